@@ -0,0 +1,702 @@
+// Host benchmarks for the BSP, run against the register simulator in sim/.
+//
+// Each benchmark reports the number of operations performed, the mean time per operation and the
+// operation rate. Numbers are only comparable between runs on the same machine; they exist to catch
+// regressions, not to predict cycle counts on the target. Correctness is checked separately, by
+// test/test.c.
+
+#define _XOPEN_SOURCE 700
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "bsp/clock.h"
+#include "bsp/debounce.h"
+#include "bsp/dsa/queue.h"
+#include "bsp/i2c.h"
+#include "bsp/idle.h"
+#include "bsp/io.h"
+#include "bsp/io_event.h"
+#include "bsp/sched.h"
+#include "bsp/sim.h"
+#include "bsp/spi.h"
+#include "bsp/usart.h"
+#include "bsp/util/assert.h"
+#include "bsp/util/log.h"
+
+#define BENCH_ITERATIONS 2000000UL
+
+// Sink for values produced by benchmarks, so that the compiler cannot discard the work
+static volatile uint32_t bench_sink;
+
+// The USART0 buffers, given to usart_init() so that the results do not depend on the size of the
+// default buffers (the usart0_rx_buffer_size and usart0_tx_buffer_size meson options)
+static char bench_rx_buffer[16];
+static char bench_tx_buffer[16];
+
+// Timing ------------------------------------------------------------------------------------------
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_report(const char *name, const char *unit, uint64_t ops, uint64_t elapsed_ns) {
+    double ns_per_op = (double)elapsed_ns / (double)ops;
+    double ops_per_s = (double)ops * 1e9 / (double)elapsed_ns;
+
+    printf("%-28s %12llu %-6s %10.2f ns/%-5s %12.0f %s/s\n",
+           name,
+           (unsigned long long)ops,
+           unit,
+           ns_per_op,
+           unit,
+           ops_per_s,
+           unit);
+}
+
+// Queue -------------------------------------------------------------------------------------------
+
+QUEUE_DECLARE_STATIC(bench_queue, uint8_t, 16);
+
+static void bench_queue_roundtrip(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint8_t in = (uint8_t)i, out;
+
+        queue_enqueue(&bench_queue, &in);
+        queue_dequeue(&bench_queue, &out);
+
+        bench_sink += out;
+    }
+
+    bench_report("queue enqueue+dequeue", "op", BENCH_ITERATIONS * 2, bench_now_ns() - start);
+}
+
+static void bench_queue_fill_drain(void) {
+    uint64_t ops   = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        uint8_t byte = (uint8_t)i;
+
+        while (!queue_is_full(&bench_queue)) {
+            queue_enqueue(&bench_queue, &byte);
+            ops++;
+        }
+
+        while (!queue_is_empty(&bench_queue)) {
+            queue_dequeue(&bench_queue, &byte);
+            ops++;
+        }
+
+        bench_sink += byte;
+    }
+
+    bench_report("queue fill+drain", "op", ops, bench_now_ns() - start);
+}
+
+static void bench_queue_bulk(void) {
+    uint8_t in[16] = {0}, out[16];
+    uint64_t ops   = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        in[0] = (uint8_t)i;
+
+        ops += queue_enqueue_n(&bench_queue, in, sizeof(in));
+        ops += queue_dequeue_n(&bench_queue, out, sizeof(out));
+
+        bench_sink += out[0];
+    }
+
+    bench_report("queue enqueue_n+dequeue_n", "op", ops, bench_now_ns() - start);
+}
+
+QUEUE_TYPED_DEFINE(bench_typed_queue, uint8_t, 16);
+
+static bench_typed_queue bench_typed;
+
+static void bench_typed_queue_roundtrip(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        uint8_t out = 0;
+
+        bench_typed_queue_enqueue(&bench_typed, (uint8_t)i);
+        bench_typed_queue_dequeue(&bench_typed, &out);
+
+        bench_sink += out;
+    }
+
+    bench_report("typed enqueue+dequeue", "op", BENCH_ITERATIONS * 2, bench_now_ns() - start);
+}
+
+static void bench_typed_queue_fill_drain(void) {
+    uint64_t ops   = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        uint8_t byte = (uint8_t)i;
+
+        while (bench_typed_queue_enqueue(&bench_typed, byte)) ops++;
+        while (bench_typed_queue_dequeue(&bench_typed, &byte)) ops++;
+
+        bench_sink += byte;
+    }
+
+    bench_report("typed fill+drain", "op", ops, bench_now_ns() - start);
+}
+
+static void bench_typed_queue_bulk(void) {
+    uint8_t in[16] = {0}, out[16];
+    uint64_t ops   = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        in[0] = (uint8_t)i;
+
+        // Offset the indices so that the spans wrap around the end of the storage
+        bench_typed_queue_enqueue(&bench_typed, 0);
+        ops += bench_typed_queue_enqueue_n(&bench_typed, in, 15);
+        ops += bench_typed_queue_dequeue_n(&bench_typed, out, sizeof(out));
+
+        bench_sink += out[1];
+    }
+
+    bench_report("typed enqueue_n+dequeue_n", "op", ops, bench_now_ns() - start);
+}
+
+// USART -------------------------------------------------------------------------------------------
+
+static void bench_usart_write(void) {
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        // Stay within the TX buffer so that usart_write() never spins; the simulated UDRE
+        // interrupt then drains everything that was queued
+        for (char c = 'a'; c < 'a' + 16; c++) usart_write(BSP_USART0, c);
+
+        bytes += sim_usart0_drain(NULL, 0);
+    }
+
+    bench_report("usart_write + UDRE ISR", "byte", bytes, bench_now_ns() - start);
+}
+
+static void bench_usart_read(void) {
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        for (uint8_t c = 0; c < 16; c++) sim_usart0_receive('a' + c);
+
+        while (usart_poll(BSP_USART0)) {
+            bench_sink += (uint8_t)usart_read(BSP_USART0);
+            bytes++;
+        }
+    }
+
+    bench_report("RX ISR + usart_read", "byte", bytes, bench_now_ns() - start);
+}
+
+static void bench_usart_write_buf(void) {
+    static const char line[16] = "0123456789abcde\n";
+
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        usart_write_buf(BSP_USART0, line, sizeof(line));
+
+        bytes += sim_usart0_drain(NULL, 0);
+    }
+
+    bench_report("usart_write_buf + UDRE ISR", "byte", bytes, bench_now_ns() - start);
+}
+
+static void bench_usart_read_buf(void) {
+    char buf[16];
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        for (uint8_t c = 0; c < 16; c++) sim_usart0_receive('a' + c);
+
+        bytes += usart_read_buf(BSP_USART0, buf, sizeof(buf));
+        bench_sink += (uint8_t)buf[15];
+    }
+
+    bench_report("RX ISR + usart_read_buf", "byte", bytes, bench_now_ns() - start);
+}
+
+static void bench_usart_readline(void) {
+    static const char line[] = "set led 1 on\r\n";
+
+    char buf[32];
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        for (const char *c = line; *c; c++) sim_usart0_receive((uint8_t)*c);
+
+        int16_t length = usart_readline(BSP_USART0, buf, sizeof(buf));
+        if (length >= 0) bytes += sizeof(line) - 1;
+
+        bench_sink += (uint8_t)length;
+    }
+
+    bench_report("RX ISR + usart_readline", "byte", bytes, bench_now_ns() - start);
+}
+
+static void bench_usart_printf(void) {
+    uint64_t messages = 0;
+    uint64_t start    = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        usart_printf(BSP_USART0, "t=%u v=%d\n", (unsigned)(i & 0xFF), -7);
+        sim_usart0_drain(NULL, 0);
+
+        messages++;
+    }
+
+    bench_report("usart_printf + UDRE ISR", "msg", messages, bench_now_ns() - start);
+}
+
+static void bench_log_write_record(void) {
+    uint64_t messages = 0;
+    uint64_t start    = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        // Same message as bench_usart_printf(), as a binary record
+        log_write_record("t=%u v=%d\n", (unsigned)(i & 0xFF), -7);
+        sim_usart0_drain(NULL, 0);
+
+        messages++;
+    }
+
+    bench_report("log_write_record + UDRE ISR", "msg", messages, bench_now_ns() - start);
+}
+
+// Echo --------------------------------------------------------------------------------------------
+
+// With the transmitter keeping up, every byte is echoed straight from the RX interrupt
+static void bench_usart_echo(void) {
+    usart_set_echo(BSP_USART0, true);
+
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sim_usart0_receive((uint8_t)('a' + (i & 15)));
+        bytes += sim_usart0_transmit(NULL);
+
+        char c;
+        usart_read_buf(BSP_USART0, &c, 1);
+    }
+
+    bench_report("RX ISR + echo + usart_read", "byte", bytes, bench_now_ns() - start);
+
+    usart_set_echo(BSP_USART0, false);
+}
+
+// Framing -----------------------------------------------------------------------------------------
+
+// A payload with bytes that both COBS and SLIP have to encode, short enough that its encoding fits
+// the TX buffer
+static const uint8_t bench_frame_payload[8] = {0x01, 0x00, 0xC0, 0xDB, 0x55, 0x00, 0xAA, 0x7F};
+
+// Loop frames back through the RX interrupt
+static void bench_usart_framing(const char *name, usart_framing framing) {
+    usart_set_framing(BSP_USART0, framing);
+
+    uint8_t encoded[32], payload[16];
+    uint64_t frames = 0;
+    uint64_t start  = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 16; i++) {
+        usart_frame_write(BSP_USART0, bench_frame_payload, sizeof(bench_frame_payload));
+
+        size_t encoded_length = sim_usart0_drain(encoded, sizeof(encoded));
+        for (size_t j = 0; j < encoded_length; j++) sim_usart0_receive(encoded[j]);
+
+        if (usart_frame_read(BSP_USART0, payload, sizeof(payload)) == sizeof(bench_frame_payload)) {
+            frames++;
+        }
+    }
+
+    bench_report(name, "frame", frames, bench_now_ns() - start);
+
+    usart_set_framing(BSP_USART0, USART_FRAMING_NONE);
+}
+
+// Flow control ------------------------------------------------------------------------------------
+
+#define BENCH_RTS_PIN BSP_PC0
+
+#define bench_rts_deasserted() (PORTC & IO_PIN_MASK(BENCH_RTS_PIN))
+
+// A sender that honours RTS (sending two bytes per check, so that it overshoots the mark) streams
+// twice as fast as the application reads, in bursts, from the RX buffer
+static void bench_usart_flow_control(void) {
+    usart_set_flow_control(BSP_USART0,
+                           (usart_flow_control){
+                               .rts_enabled    = true,
+                               .rts_pin        = BENCH_RTS_PIN,
+                               .rts_high_water = 8,
+                           });
+
+    uint8_t next_sent = 0;
+    uint64_t bytes    = 0;
+    uint64_t start    = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        if (!bench_rts_deasserted()) {
+            sim_usart0_receive(next_sent++);
+            sim_usart0_receive(next_sent++);
+        }
+
+        if (i % 8 != 7) continue;
+
+        char burst[8];
+        bytes += usart_read_buf(BSP_USART0, burst, sizeof(burst));
+    }
+
+    bench_report("RX ISR + read with RTS", "byte", bytes, bench_now_ns() - start);
+
+    char rest[16];
+    usart_read_buf(BSP_USART0, rest, sizeof(rest));
+
+    usart_set_flow_control(BSP_USART0, (usart_flow_control){0});
+}
+
+// SPI ---------------------------------------------------------------------------------------------
+
+#define BENCH_SPI_CS_PIN BSP_PC1
+
+// Keep the queue full of 16-byte transfers
+static void bench_spi(void) {
+    spi_init((spi_config){.clock = SPI_CLOCK_DIV_2, .mode = SPI_MODE_0});
+    io_configure(BENCH_SPI_CS_PIN,
+                 (io_config){.direction = IO_DIRECTION_OUTPUT, .initial_level = IO_HIGH});
+
+    static uint8_t buffers[4][16];
+    spi_transfer queued[4];
+
+    for (uint8_t i = 0; i < 4; i++) {
+        queued[i] = (spi_transfer){
+            .cs_pin = BENCH_SPI_CS_PIN,
+            .tx_buf = buffers[i],
+            .rx_buf = buffers[i],
+            .length = sizeof(buffers[i]),
+        };
+    }
+
+    uint64_t bytes = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 64; i++) {
+        for (uint8_t j = 0; j < 4; j++) spi_submit(&queued[j]);
+
+        bytes += sim_spi_run(NULL, NULL, 0);
+    }
+
+    bench_report("spi_submit + SPI ISR", "byte", bytes, bench_now_ns() - start);
+}
+
+// I2C ---------------------------------------------------------------------------------------------
+
+#define BENCH_I2C_ADDRESS 0x50
+
+// The registers of the simulated device
+static uint8_t bench_i2c_memory[16];
+
+// Keep the queue full of register reads
+static void bench_i2c(void) {
+    i2c_init((i2c_config){.frequency = I2C_FREQUENCY_FAST});
+    sim_twi_attach(BENCH_I2C_ADDRESS, bench_i2c_memory, sizeof(bench_i2c_memory));
+
+    static const uint8_t pointer[1] = {0x02};
+    static uint8_t buffers[4][4];
+    i2c_transaction queued[4];
+
+    for (uint8_t i = 0; i < 4; i++) {
+        queued[i] = (i2c_transaction){
+            .address   = BENCH_I2C_ADDRESS,
+            .tx_buf    = pointer,
+            .tx_length = sizeof(pointer),
+            .rx_buf    = buffers[i],
+            .rx_length = sizeof(buffers[i]),
+        };
+    }
+
+    uint64_t count = 0;
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS / 256; i++) {
+        for (uint8_t j = 0; j < 4; j++) count += i2c_submit(&queued[j]);
+
+        sim_twi_run();
+    }
+
+    bench_report("i2c_submit + TWI ISR", "transaction", count, bench_now_ns() - start);
+}
+
+// Blocking waits --------------------------------------------------------------------------------
+
+// Each sleep stands in for the interrupt that wakes the CPU, here a received byte
+static void bench_sleep_receive(void) {
+    sim_usart0_receive('x');
+}
+
+static void bench_usart_blocking(void) {
+    sei();
+    sim_set_sleep_hook(bench_sleep_receive);
+
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) bench_sink += usart_read(BSP_USART0);
+
+    bench_report("usart_read (sleep + RX ISR)", "byte", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    sim_set_sleep_hook(NULL);
+    cli();
+}
+
+// Scheduler ---------------------------------------------------------------------------------------
+
+static void bench_sched_rx_task(sched_events events) {
+    (void)events;
+
+    char buf[16];
+    bench_sink += usart_read_buf(BSP_USART0, buf, sizeof(buf));
+}
+
+// Measure the time from a received byte to the task that handles it
+static void bench_sched(void) {
+    static const sched_task tasks[] = {
+        {.events = SCHED_EVENT_USART0_RX, .run = bench_sched_rx_task},
+    };
+
+    sched_init(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    sched_run_once();
+
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sim_usart0_receive((uint8_t)('a' + (i & 15)));
+        sched_run_once();
+    }
+
+    bench_report("RX ISR -> sched task", "byte", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// IO ----------------------------------------------------------------------------------------------
+
+// Pins that the compiler can't see through, to measure the runtime (table) path
+static volatile io_pin bench_output_pin = BSP_PB5;
+static volatile io_pin bench_input_pin  = BSP_PD2;
+
+static void bench_io_write(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_write(BSP_PB5, (io_logic_level)(i & 1));
+
+    bench_report("io_write", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    io_pin pin = bench_output_pin;
+    start      = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_write(pin, (io_logic_level)(i & 1));
+
+    bench_report("io_write (runtime pin)", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+static void bench_io_read(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) bench_sink += io_read(BSP_PD2);
+
+    bench_report("io_read", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    io_pin pin = bench_input_pin;
+    start      = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) bench_sink += io_read(pin);
+
+    bench_report("io_read (runtime pin)", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+static void bench_io_toggle(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_toggle(BSP_PB5);
+
+    bench_report("io_toggle", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    io_pin pin = bench_output_pin;
+    start      = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_toggle(pin);
+
+    bench_report("io_toggle (runtime pin)", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+static void bench_io_write_mask(void) {
+    uint64_t start = bench_now_ns();
+
+    // An 8-bit parallel bus on port D
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_write_mask(IO_PORT_D, 0xFF, (uint8_t)i);
+
+    bench_report("io_write_mask", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+static void bench_io_toggle_mask(void) {
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) io_toggle_mask(IO_PORT_B, 0x0F);
+
+    bench_report("io_toggle_mask", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+// IO events ---------------------------------------------------------------------------------------
+
+static void bench_io_event_callback(io_pin pin, io_logic_level level) {
+    (void)pin;
+    (void)level;
+
+    bench_sink++;
+}
+
+// Measure the time from a simulated input edge to its callback, for an external interrupt pin and
+// a pin change interrupt pin (with another watched pin on the same port). This is host time through
+// the simulator, which leaves out interrupt entry and exit; see bsp/io_event.h for the estimated
+// latency on the target.
+static void bench_io_event(const char *name, io_pin pin, io_edge edge) {
+    uint8_t port = IO_PORT_IDX(pin);
+    uint8_t mask = IO_PIN_MASK(pin);
+
+    // Start low, so that every iteration below is an edge (alternately rising and falling)
+    io_configure(pin, (io_config){.direction = IO_DIRECTION_INPUT});
+    sim_port_input(port, 0);
+    io_event_register(pin, edge, bench_io_event_callback);
+
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        sim_port_input(port, (i & 1) ? 0 : mask);
+    }
+
+    bench_report(name, "edge", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    io_event_unregister(pin);
+}
+
+// Debounce ----------------------------------------------------------------------------------------
+
+static void bench_debounce(void) {
+    // 20 inputs: all of port B, PC0 to PC5 and PD2 to PD7
+    debounce_init(1);
+    debounce_add_mask(IO_PORT_B, 0xFF);
+    debounce_add_mask(IO_PORT_C, 0x3F);
+    debounce_add_mask(IO_PORT_D, 0xFC);
+
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        // Port B bounces on every tick
+        PINB = (uint8_t)(i * 0x9D);
+        sim_timer2_compare_a();
+    }
+
+    bench_report("debounce tick (20 pins)", "tick", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    bench_sink += debounce_take_rising(IO_PORT_B, 0xFF);
+}
+
+// Clock -------------------------------------------------------------------------------------------
+
+static void bench_clock(void) {
+    clock_init();
+
+    uint64_t start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) bench_sink += bsp_micros();
+
+    bench_report("bsp_micros", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) bench_sink += bsp_cycles();
+
+    bench_report("bsp_cycles", "call", BENCH_ITERATIONS, bench_now_ns() - start);
+}
+
+int main(void) {
+    // Label the results, since the assert level changes the cost of the USART hot paths
+    printf("assert level %d\n", BSP_ASSERT_LEVEL);
+
+    sim_reset();
+
+    usart_init(BSP_USART0,
+               (usart_config){
+                   .baud_rate            = USART_BAUD_115200,
+                   .rx_buffer            = bench_rx_buffer,
+                   .rx_buffer_size       = sizeof(bench_rx_buffer),
+                   .tx_buffer            = bench_tx_buffer,
+                   .tx_buffer_size       = sizeof(bench_tx_buffer),
+                   .rx_delimiter_enabled = true,
+                   .rx_delimiter         = '\n',
+               });
+    io_configure(BSP_PB5, (io_config){.direction = IO_DIRECTION_OUTPUT});
+    io_configure(BSP_PD2, (io_config){.direction = IO_DIRECTION_INPUT});
+    io_configure_mask(IO_PORT_B, 0x0F, (io_config){.direction = IO_DIRECTION_OUTPUT});
+
+    bench_queue_roundtrip();
+    bench_queue_fill_drain();
+    bench_queue_bulk();
+    bench_typed_queue_roundtrip();
+    bench_typed_queue_fill_drain();
+    bench_typed_queue_bulk();
+
+    bench_usart_write();
+    bench_usart_read();
+    bench_usart_write_buf();
+    bench_usart_read_buf();
+    bench_usart_readline();
+    bench_usart_printf();
+    bench_log_write_record();
+
+    bench_io_write();
+    bench_io_read();
+    bench_io_toggle();
+    bench_io_write_mask();
+    bench_io_toggle_mask();
+
+    bench_io_event("INT0 edge -> callback", BSP_PD2, IO_EDGE_BOTH);
+    bench_io_event("INT0 rising -> callback", BSP_PD2, IO_EDGE_RISING);
+
+    // Watch a second pin of port B, so that the handler has to pick out the one that changed
+    io_event_register(BSP_PB1, IO_EDGE_BOTH, bench_io_event_callback);
+    bench_io_event("PCINT0 edge -> callback", BSP_PB0, IO_EDGE_BOTH);
+    bench_io_event("PCINT0 falling -> callback", BSP_PB0, IO_EDGE_FALLING);
+    io_event_unregister(BSP_PB1);
+
+    bench_debounce();
+    bench_clock();
+    bench_usart_blocking();
+    bench_usart_echo();
+    bench_usart_framing("COBS write + RX ISR + read", USART_FRAMING_COBS);
+    bench_usart_framing("SLIP write + RX ISR + read", USART_FRAMING_SLIP);
+    bench_usart_flow_control();
+    bench_sched();
+    bench_spi();
+    bench_i2c();
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef _CALEBRJC_BSP_CLOCK_H_
+#define _CALEBRJC_BSP_CLOCK_H_
+
+#include <stdint.h>
+
+/// @brief Monotonic time base.
+
+// Note:
+// Timer0 counts the system clock divided by 64 and its overflow interrupt keeps the millisecond
+// count, like most AVR runtimes: bsp_micros() has a resolution of 64 cycles (4 us at 16 MHz).
+// Timer1 counts every cycle, and its overflow interrupt extends it to 32 bits for bsp_cycles(),
+// which wraps after 2^32 cycles (about 268 s at 16 MHz); differences of up to that long are still
+// correct with unsigned arithmetic.
+//
+// The clock owns Timer0, Timer1 and their overflow interrupts. F_CPU must be 1, 2, 4, 8 or 16 MHz
+// (a whole number of microseconds per Timer0 tick).
+
+/// @brief Start Timer0 and Timer1. The clocks read 0 until this is called.
+void clock_init(void);
+
+/// @brief Return the time since clock_init() was called, in milliseconds (wraps after ~49 days).
+///        Can be used as a log timestamp source (see log_set_timestamp_source()).
+/// @return The time since clock_init() was called, in milliseconds.
+uint32_t bsp_millis(void);
+
+/// @brief Return the time since clock_init() was called, in microseconds (wraps after ~71
+///        minutes).
+/// @return The time since clock_init() was called, in microseconds.
+uint32_t bsp_micros(void);
+
+/// @brief Return the number of CPU cycles since clock_init() was called, modulo 2^32.
+/// @return The number of CPU cycles since clock_init() was called.
+uint32_t bsp_cycles(void);
+
+#endif  // _CALEBRJC_BSP_CLOCK_H_
@@ -0,0 +1,74 @@
+#ifndef _CALEBRJC_BSP_DEBOUNCE_H_
+#define _CALEBRJC_BSP_DEBOUNCE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bsp/io.h"
+
+/// @brief Debounced sampling of input pins.
+
+// Note:
+// Timer2 samples every port on each tick, and each port is debounced as a whole with a vertical
+// counter: two bytes hold a 2-bit counter for each of its 8 pins, so one tick costs a handful of
+// bitwise operations per port however many pins are debounced. A pin's debounced state changes once
+// it has read the opposite level on 4 consecutive ticks. The change posts SCHED_EVENT_DEBOUNCE (see
+// bsp/sched.h) and is latched as a rising or falling edge until it is taken with
+// debounce_take_rising() or debounce_take_falling().
+//
+// The debounce service owns Timer2 and its compare match A interrupt.
+
+/// @brief The number of consecutive ticks for which a pin must read a new level to change its
+///        debounced state.
+#define DEBOUNCE_TICKS 4
+
+/// @brief Start sampling on Timer2.
+/// @param period_ms The time between ticks, in milliseconds (at most 16 at 16 MHz). A bounce time
+///        of up to DEBOUNCE_TICKS * period_ms is filtered out.
+void debounce_init(uint8_t period_ms);
+
+/// @brief Debounce several pins of an IO port, starting from their current levels. Configure the
+///        pins as inputs first (see io_configure_mask()).
+/// @param port The port of the pins.
+/// @param mask The pins to debounce.
+void debounce_add_mask(io_port port, uint8_t mask);
+
+/// @brief Debounce an IO pin, starting from its current level. Configure the pin as an input first
+///        (see io_configure()).
+/// @param pin The pin to debounce.
+void debounce_add(io_pin pin);
+
+/// @brief Return the debounced levels of an IO port.
+/// @param port The port to read.
+/// @return The debounced levels of the port's debounced pins (bit n for pin n), and 0 for the
+///         others.
+uint8_t debounce_read_port(io_port port);
+
+/// @brief Return the debounced level of an IO pin.
+/// @param pin The pin to read.
+/// @return The debounced level of the pin (IO_LOW if it is not debounced).
+io_logic_level debounce_read(io_pin pin);
+
+/// @brief Return and clear the latched rising edges of several pins of an IO port.
+/// @param port The port of the pins.
+/// @param mask The pins to check.
+/// @return The pins in mask that rose since their edges were last taken (bit n for pin n).
+uint8_t debounce_take_rising(io_port port, uint8_t mask);
+
+/// @brief Return and clear the latched falling edges of several pins of an IO port.
+/// @param port The port of the pins.
+/// @param mask The pins to check.
+/// @return The pins in mask that fell since their edges were last taken (bit n for pin n).
+uint8_t debounce_take_falling(io_port port, uint8_t mask);
+
+/// @brief Return and clear the latched rising edge of an IO pin.
+/// @param pin The pin to check.
+/// @return True if the pin rose since its edges were last taken.
+bool debounce_rose(io_pin pin);
+
+/// @brief Return and clear the latched falling edge of an IO pin.
+/// @param pin The pin to check.
+/// @return True if the pin fell since its edges were last taken.
+bool debounce_fell(io_pin pin);
+
+#endif  // _CALEBRJC_BSP_DEBOUNCE_H_
@@ -24,7 +24,26 @@
 /// use some synchronization primitive e.g. condition variable, but I don't have access to those
 /// yet, so I'm going to stick with volatile for now.)
 
+/// Note:
+/// Queues are safe to share between exactly one producer and one consumer (e.g. an ISR and the main
+/// loop) without disabling interrupts, as long as:
+/// - only the producer calls the enqueue operations, and only the consumer calls the dequeue/peek
+///   operations;
+/// - the producer only ever writes head_idx, and the consumer only ever writes tail_idx;
+/// - the indices are single bytes, so that each side reads the other's index atomically.
+/// Each operation reads the other side's index once, and publishes its own index only after the
+/// element has been copied, so a preempted operation never exposes a partially written element.
+/// This holds for both the generic queue and the typed queues below.
+
+/// @brief Prevent the compiler from moving memory accesses across this point. Element copies are
+///        not volatile accesses, so queues use this to order them against index updates.
+#define QUEUE_COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
 /// @brief Queue data structure, implemented as a circular buffer of a fixed size.
+///
+/// The head and tail indices run over [0, 2 * data_size) so that a full queue (indices that differ
+/// by data_size) can be told apart from an empty one (equal indices) without a shared flag. This
+/// limits the queue to QUEUE_MAX_SIZE elements.
 typedef volatile struct {
     /// @brief The queue's data storage.
     uint8_t *data;
@@ -35,29 +54,29 @@ typedef volatile struct {
     /// @brief The size of each element in the queue.
     size_t element_size;
 
-    /// @brief The index of the front of the queue.
-    size_t head_idx;
+    /// @brief The index of the back of the queue (written by the producer only).
+    uint8_t head_idx;
 
-    /// @brief The index of the back of the queue.
-    size_t tail_idx;
-
-    /// @brief True if the queue is full, and false otherwise.
-    bool is_full;
+    /// @brief The index of the front of the queue (written by the consumer only).
+    uint8_t tail_idx;
 } queue;
 
-#define QUEUE_DECLARE_IMPL(identifier, T, size, qualifier) \
-    qualifier uint8_t identifier##_data[size * sizeof(T)]; \
-    qualifier queue identifier = {                         \
-        .data         = identifier##_data,                 \
-        .data_size    = size,                              \
-        .element_size = sizeof(T),                         \
-        .head_idx     = 0,                                 \
-        .tail_idx     = 0,                                 \
-        .is_full      = false,                             \
+/// @brief The maximum number of elements in a queue.
+#define QUEUE_MAX_SIZE 127
+
+#define QUEUE_DECLARE_IMPL(identifier, T, size, qualifier)                                \
+    _Static_assert((size) > 0 && (size) <= QUEUE_MAX_SIZE, #identifier ": invalid size"); \
+    qualifier uint8_t identifier##_data[size * sizeof(T)];                                \
+    qualifier queue identifier = {                                                        \
+        .data         = identifier##_data,                                                \
+        .data_size    = size,                                                             \
+        .element_size = sizeof(T),                                                        \
+        .head_idx     = 0,                                                                \
+        .tail_idx     = 0,                                                                \
     }
 
-#define QUEUE_DECLARE(identifier, size, T)        QUEUE_DECLARE_IMPL(identifier, size, T, )
-#define QUEUE_DECLARE_STATIC(identifier, size, T) QUEUE_DECLARE_IMPL(identifier, size, T, static)
+#define QUEUE_DECLARE(identifier, T, size)        QUEUE_DECLARE_IMPL(identifier, T, size, )
+#define QUEUE_DECLARE_STATIC(identifier, T, size) QUEUE_DECLARE_IMPL(identifier, T, size, static)
 
 /// @brief Enqueue data into the queue, or do nothing if the queue is full.
 /// @param q The queue to enqueue data into.
@@ -76,6 +95,46 @@ void queue_dequeue(queue *q, void *o_data);
 /// @param o_data The data at the front of the queue, or NULL if the queue is empty.
 void queue_peek(const queue *q, void *o_data);
 
+/// @brief Enqueue up to count elements into the queue, stopping early if the queue becomes full.
+/// @param q The queue to enqueue data into.
+/// @param data The elements to enqueue.
+/// @param count The number of elements in data.
+/// @return The number of elements enqueued.
+size_t queue_enqueue_n(queue *q, const void *data, size_t count);
+
+/// @brief Dequeue up to count elements from the queue, stopping early if the queue becomes empty.
+/// @param q The queue to dequeue data from.
+/// @param o_data The buffer to store the dequeued elements in.
+/// @param count The maximum number of elements to dequeue.
+/// @return The number of elements dequeued.
+size_t queue_dequeue_n(queue *q, void *o_data, size_t count);
+
+/// @brief Return the largest contiguous span of free elements in the queue's storage, so that the
+/// producer can write elements in place. The elements are not enqueued until
+/// queue_commit_write() is called.
+/// @param q The queue to reserve space in.
+/// @param o_count The number of elements in the returned span (possibly 0).
+/// @return The start of the span.
+void *queue_reserve_write(queue *q, size_t *o_count);
+
+/// @brief Enqueue elements written in place after queue_reserve_write().
+/// @param q The queue to commit elements to.
+/// @param count The number of elements to enqueue (at most the number reserved).
+void queue_commit_write(queue *q, size_t count);
+
+/// @brief Return the largest contiguous span of elements at the front of the queue, so that the
+/// consumer can read elements in place. The elements are not dequeued until queue_commit_read() is
+/// called.
+/// @param q The queue to read from.
+/// @param o_count The number of elements in the returned span (possibly 0).
+/// @return The start of the span.
+const void *queue_reserve_read(const queue *q, size_t *o_count);
+
+/// @brief Dequeue elements read in place after queue_reserve_read().
+/// @param q The queue to remove elements from.
+/// @param count The number of elements to dequeue (at most the number reserved).
+void queue_commit_read(queue *q, size_t count);
+
 /// @brief Return the number of elements in the queue.
 /// @param q The queue to get the size of.
 /// @return The number of elements in the queue.
@@ -91,4 +150,197 @@ bool queue_is_empty(const queue *q);
 /// @return True if the queue is full, and false otherwise.
 bool queue_is_full(const queue *q);
 
+// Typed queues ------------------------------------------------------------------------------------
+
+// Note:
+// The queue above is generic at runtime, which costs a memcpy() and a multiplication per element.
+// Typed queues fix the element type and capacity at compile time instead: the capacity must be a
+// power of two so that indexing is a mask, elements are copied by assignment, and every operation
+// is a static inline function that the compiler can fold into the caller (e.g. an ISR).
+//
+// The head and tail indices are free-running 8-bit counters, so the number of elements is simply
+// their difference and no separate "full" flag is needed. This limits the capacity to 128. Typed
+// queues follow the same single-producer/single-consumer rules as the generic queue.
+
+/// @brief Define a queue type, and its operations, for up to capacity elements of type T.
+///
+/// For a type named name, the following functions are defined:
+/// - bool name_enqueue(name *q, T value): Enqueue value, returning false if the queue is full.
+/// - bool name_dequeue(name *q, T *o_value): Dequeue into o_value, returning false if the queue is
+///   empty.
+/// - bool name_peek(const name *q, T *o_value): Like name_dequeue(), without removing the element.
+/// - uint8_t name_enqueue_n(name *q, const T *values, uint8_t count),
+///   uint8_t name_dequeue_n(name *q, T *o_values, uint8_t count): Like queue_enqueue_n() and
+///   queue_dequeue_n().
+/// - T *name_reserve_write(name *q, uint8_t *o_count), void name_commit_write(name *q, uint8_t
+///   count), const T *name_reserve_read(const name *q, uint8_t *o_count), void
+///   name_commit_read(name *q, uint8_t count): Like queue_reserve_write() and friends.
+/// - bool name_stage(name *q, uint8_t offset, T value): Write value offset elements past the back
+///   of the queue without enqueuing it, returning false if the queue has no room for it. Unlike
+///   name_reserve_write(), staged elements may wrap around the end of the storage; enqueue them
+///   with name_commit_write().
+/// - uint8_t name_size(const name *q): Return the number of elements in the queue.
+/// - bool name_is_empty(const name *q), bool name_is_full(const name *q)
+///
+/// A zero-initialized queue is empty, so instances need no further initialization.
+///
+/// @param name The name of the queue type (and the prefix of its functions).
+/// @param T The type of the elements in the queue.
+/// @param capacity The maximum number of elements in the queue (a power of two, at most 128).
+#define QUEUE_TYPED_DEFINE(name, T, capacity)                                                 \
+    _Static_assert((capacity) > 0 && (capacity) <= 128 && ((capacity) & ((capacity)-1)) == 0, \
+                   #name ": capacity must be a power of two no greater than 128");            \
+                                                                                              \
+    /* Only the indices are volatile, so that elements can be handed out by reserve/commit */ \
+    typedef struct {                                                                          \
+        T data[capacity];                                                                     \
+        volatile uint8_t head_idx;                                                            \
+        volatile uint8_t tail_idx;                                                            \
+    } name;                                                                                   \
+                                                                                              \
+    QUEUE_TYPED_DEFINE_IMPL(name, T, (capacity))
+
+/// @brief Define a queue type, and its operations, for elements of type T kept in caller-provided
+/// storage. The functions are the same as for QUEUE_TYPED_DEFINE(), plus:
+/// - bool name_init(name *q, T *storage, uint8_t capacity): Set up an empty queue over storage,
+///   returning false if capacity is not a power of two no greater than 128. A capacity of 0 is
+///   allowed, and makes a queue that is always both empty and full.
+///
+/// Indexing reads the capacity from the queue instead of folding it into the code, which costs a
+/// couple of loads per operation in exchange for sizing the storage at runtime.
+///
+/// @param name The name of the queue type (and the prefix of its functions).
+/// @param T The type of the elements in the queue.
+#define QUEUE_TYPED_DEFINE_EXTERNAL(name, T)                                \
+    typedef struct {                                                        \
+        T *data;                                                            \
+        uint8_t capacity;                                                   \
+        volatile uint8_t head_idx;                                          \
+        volatile uint8_t tail_idx;                                          \
+    } name;                                                                 \
+                                                                            \
+    static inline bool name##_init(name *q, T *storage, uint8_t capacity) { \
+        if (capacity > 128 || (capacity & (capacity - 1))) return false;    \
+                                                                            \
+        q->data     = storage;                                              \
+        q->capacity = capacity;                                             \
+        q->head_idx = 0;                                                    \
+        q->tail_idx = 0;                                                    \
+        return true;                                                        \
+    }                                                                       \
+                                                                            \
+    QUEUE_TYPED_DEFINE_IMPL(name, T, (q->capacity))
+
+// The operations shared by typed queues, where capacity_expr evaluates to the capacity of queue q
+#define QUEUE_TYPED_DEFINE_IMPL(name, T, capacity_expr)                               \
+    static inline uint8_t name##_size(const name *q) {                                \
+        return (uint8_t)(q->head_idx - q->tail_idx);                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_is_empty(const name *q) {                               \
+        return q->head_idx == q->tail_idx;                                            \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_is_full(const name *q) {                                \
+        return name##_size(q) == (capacity_expr);                                     \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_enqueue(name *q, T value) {                             \
+        uint8_t head = q->head_idx;                                                   \
+        if ((uint8_t)(head - q->tail_idx) == (capacity_expr)) return false;           \
+                                                                                      \
+        q->data[head & ((capacity_expr)-1)] = value;                                  \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        q->head_idx = head + 1;                                                       \
+        return true;                                                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_peek(const name *q, T *o_value) {                       \
+        uint8_t tail = q->tail_idx;                                                   \
+        if (q->head_idx == tail) return false;                                        \
+                                                                                      \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        *o_value = q->data[tail & ((capacity_expr)-1)];                               \
+        return true;                                                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_dequeue(name *q, T *o_value) {                          \
+        if (!name##_peek(q, o_value)) return false;                                   \
+                                                                                      \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        q->tail_idx++;                                                                \
+        return true;                                                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline T *name##_reserve_write(name *q, uint8_t *o_count) {                \
+        uint8_t head       = q->head_idx;                                             \
+        uint8_t free_count = (capacity_expr) - (uint8_t)(head - q->tail_idx);         \
+        uint8_t contiguous = (capacity_expr) - (head & ((capacity_expr)-1));          \
+                                                                                      \
+        *o_count = (free_count < contiguous) ? free_count : contiguous;               \
+        return &q->data[head & ((capacity_expr)-1)];                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline bool name##_stage(name *q, uint8_t offset, T value) {               \
+        uint8_t head = q->head_idx;                                                   \
+        if ((uint8_t)(head - q->tail_idx) + offset >= (capacity_expr)) return false;  \
+                                                                                      \
+        q->data[(uint8_t)(head + offset) & ((capacity_expr)-1)] = value;              \
+        return true;                                                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline void name##_commit_write(name *q, uint8_t count) {                  \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        q->head_idx += count;                                                         \
+    }                                                                                 \
+                                                                                      \
+    static inline const T *name##_reserve_read(const name *q, uint8_t *o_count) {     \
+        uint8_t tail       = q->tail_idx;                                             \
+        uint8_t used_count = (uint8_t)(q->head_idx - tail);                           \
+        uint8_t contiguous = (capacity_expr) - (tail & ((capacity_expr)-1));          \
+                                                                                      \
+        *o_count = (used_count < contiguous) ? used_count : contiguous;               \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        return &q->data[tail & ((capacity_expr)-1)];                                  \
+    }                                                                                 \
+                                                                                      \
+    static inline void name##_commit_read(name *q, uint8_t count) {                   \
+        QUEUE_COMPILER_BARRIER();                                                     \
+        q->tail_idx += count;                                                         \
+    }                                                                                 \
+                                                                                      \
+    static inline uint8_t name##_enqueue_n(name *q, const T *values, uint8_t count) { \
+        uint8_t total = 0;                                                            \
+                                                                                      \
+        /* The free space wraps around the end of the storage at most once */         \
+        for (uint8_t pass = 0; pass < 2 && total < count; pass++) {                   \
+            uint8_t span;                                                             \
+            T *dst = name##_reserve_write(q, &span);                                  \
+            if (span > count - total) span = count - total;                           \
+                                                                                      \
+            for (uint8_t i = 0; i < span; i++) dst[i] = values[total + i];            \
+            name##_commit_write(q, span);                                             \
+            total += span;                                                            \
+        }                                                                             \
+                                                                                      \
+        return total;                                                                 \
+    }                                                                                 \
+                                                                                      \
+    static inline uint8_t name##_dequeue_n(name *q, T *o_values, uint8_t count) {     \
+        uint8_t total = 0;                                                            \
+                                                                                      \
+        /* The queued elements wrap around the end of the storage at most once */     \
+        for (uint8_t pass = 0; pass < 2 && total < count; pass++) {                   \
+            uint8_t span;                                                             \
+            const T *src = name##_reserve_read(q, &span);                             \
+            if (span > count - total) span = count - total;                           \
+                                                                                      \
+            for (uint8_t i = 0; i < span; i++) o_values[total + i] = src[i];          \
+            name##_commit_read(q, span);                                              \
+            total += span;                                                            \
+        }                                                                             \
+                                                                                      \
+        return total;                                                                 \
+    }
+
 #endif  // _CALEBRJC_BSP_DSA_QUEUE_H_
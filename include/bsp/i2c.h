@@ -0,0 +1,146 @@
+#ifndef _CALEBRJC_BSP_I2C_H_
+#define _CALEBRJC_BSP_I2C_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief Interrupt-driven I2C (TWI) master.
+
+// Note:
+// Transactions are described by i2c_transaction descriptors, which the application owns and
+// submits to a queue (sized by the i2c_queue_size meson option). The whole bus protocol runs in
+// the TWI interrupt, one step per bus event: it addresses the device, writes tx_buf, issues a
+// repeated start and reads rx_buf, then completes the transaction with a STOP and starts the next
+// queued one in the same handler. The main loop only submits transactions and checks their status,
+// so a register read costs it a few microseconds instead of the hundreds that the bus takes.
+//
+// The driver owns the TWI pins (PC4 and PC5) and the TWI interrupt.
+
+/// @brief Standard mode bus frequency, in Hz.
+#define I2C_FREQUENCY_STANDARD 100000UL
+
+/// @brief Fast mode bus frequency, in Hz.
+#define I2C_FREQUENCY_FAST 400000UL
+
+/// @brief Configuration for the I2C bus.
+typedef struct {
+    /// @brief The SCL frequency, in Hz (e.g. I2C_FREQUENCY_FAST). The closest frequency that is not
+    ///        faster is used.
+    uint32_t frequency;
+
+    /// @brief Whether to enable the internal pull-ups on SDA and SCL. They are too weak for fast
+    ///        mode on most buses, which need external pull-ups.
+    bool internal_pullups;
+} i2c_config;
+
+/// @brief The state or outcome of an I2C transaction.
+typedef enum {
+    /// @brief The transaction has not been submitted (or was not accepted).
+    I2C_STATUS_IDLE,
+
+    /// @brief The transaction is waiting in the queue.
+    I2C_STATUS_QUEUED,
+
+    /// @brief The transaction is in progress.
+    I2C_STATUS_ACTIVE,
+
+    /// @brief The transaction completed.
+    I2C_STATUS_DONE,
+
+    /// @brief No device acknowledged the address.
+    I2C_STATUS_ADDRESS_NACK,
+
+    /// @brief The device did not acknowledge a byte written to it.
+    I2C_STATUS_DATA_NACK,
+
+    /// @brief Another master won arbitration of the bus.
+    I2C_STATUS_ARBITRATION_LOST,
+
+    /// @brief An illegal START or STOP condition was detected on the bus.
+    I2C_STATUS_BUS_ERROR,
+} i2c_status;
+
+typedef struct i2c_transaction i2c_transaction;
+
+/// @brief A callback to be called when an I2C transaction completes or fails.
+/// @param transaction The transaction, whose status tells how it ended.
+typedef void (*i2c_callback)(i2c_transaction *transaction);
+
+/// @brief An I2C transaction: a write, a read, or a write followed by a read after a repeated
+///        start (e.g. to write a register address, then read the register). The descriptor and its
+///        buffers must stay valid until the transaction ends.
+struct i2c_transaction {
+    /// @brief The 7-bit address of the device.
+    uint8_t address;
+
+    /// @brief The bytes to write.
+    const uint8_t *tx_buf;
+
+    /// @brief The number of bytes to write, or 0 to only read.
+    uint8_t tx_length;
+
+    /// @brief The buffer to store the bytes read in.
+    uint8_t *rx_buf;
+
+    /// @brief The number of bytes to read, or 0 to only write.
+    uint8_t rx_length;
+
+    /// @brief The function to call when the transaction ends, or NULL (which builds with the
+    ///        isr_callbacks meson option off require; see bsp/sched.h).
+    i2c_callback on_complete;
+
+    /// @brief Application data for on_complete.
+    void *context;
+
+    /// @brief The state or outcome of the transaction (written by the driver).
+    volatile i2c_status status;
+};
+
+/// @brief Error counters for the I2C bus. Counters wrap around on overflow.
+typedef struct {
+    /// @brief The number of transactions that completed.
+    uint16_t transactions;
+
+    /// @brief The number of transactions whose address was not acknowledged.
+    uint16_t address_nacks;
+
+    /// @brief The number of transactions with a byte that was not acknowledged.
+    uint16_t data_nacks;
+
+    /// @brief The number of transactions that lost arbitration.
+    uint16_t arbitration_lost;
+
+    /// @brief The number of bus errors.
+    uint16_t bus_errors;
+} i2c_stats;
+
+/// @brief Initialize the TWI as an I2C master.
+/// @param config The configuration to use.
+void i2c_init(i2c_config config);
+
+/// @brief Queue a transaction, starting it at once if the bus is idle. Its end posts
+///        SCHED_EVENT_I2C (see bsp/sched.h) and calls its on_complete callback in an interrupt
+///        context, after starting the next queued transaction; callbacks may submit further
+///        transactions.
+/// @param transaction The transaction to queue.
+/// @return True if the transaction was queued, or false if the queue is full.
+bool i2c_submit(i2c_transaction *transaction);
+
+/// @brief Queue a transaction and wait (see bsp/idle.h) until it ends, including for room in the
+///        queue.
+/// @param transaction The transaction to run.
+/// @return The outcome of the transaction.
+i2c_status i2c_transfer_blocking(i2c_transaction *transaction);
+
+/// @brief Return true if the bus has transactions in progress or queued.
+/// @return True if the bus is busy.
+bool i2c_busy(void);
+
+/// @brief Return the bus's error counters.
+/// @return A snapshot of the bus's counters.
+i2c_stats i2c_get_stats(void);
+
+/// @brief Reset the bus's error counters to zero.
+void i2c_reset_stats(void);
+
+#endif  // _CALEBRJC_BSP_I2C_H_
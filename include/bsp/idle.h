@@ -0,0 +1,54 @@
+#ifndef _CALEBRJC_BSP_IDLE_H_
+#define _CALEBRJC_BSP_IDLE_H_
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdint.h>
+
+/// @brief Waiting for interrupts in blocking calls.
+
+// Note:
+// A blocking call that cannot make progress until an interrupt does something (e.g. usart_read()
+// waiting for the RX interrupt) waits with idle_wait_while() instead of spinning. By default, this
+// puts the CPU in idle sleep mode, from which any interrupt wakes it; the condition is checked with
+// interrupts disabled and the CPU goes to sleep in the instruction after it re-enables them, so an
+// interrupt that arrives in between cannot be missed. If an idle hook is registered, it is called
+// instead (e.g. to run other work), and the blocking call checks again when it returns.
+//
+// If interrupts are disabled when a blocking call waits, nothing can wake the CPU, so it spins
+// instead.
+
+/// @brief A function called by blocking calls while they wait.
+typedef void (*idle_hook)(void);
+
+/// @brief Set the function that blocking calls run while they wait, instead of sleeping.
+/// @param hook The idle hook, or NULL to sleep.
+void idle_set_hook(idle_hook hook);
+
+/// @brief Wait for an interrupt: run the idle hook, or sleep until an interrupt if there is none.
+///        Use idle_wait_while() instead of calling this directly.
+/// @param sreg The status register to restore, as returned by idle_begin().
+void idle_wait(uint8_t sreg);
+
+/// @brief Disable interrupts to check whether to wait. Use idle_wait_while() instead of calling
+///        this directly.
+/// @return The status register before interrupts were disabled.
+static inline uint8_t idle_begin(void) {
+    uint8_t sreg = SREG;
+    cli();
+
+    return sreg;
+}
+
+/// @brief Wait for an interrupt if a condition holds (it is checked with interrupts disabled).
+#define idle_wait_while(condition)         \
+    do {                                   \
+        uint8_t _idle_sreg = idle_begin(); \
+        if (condition) {                   \
+            idle_wait(_idle_sreg);         \
+        } else {                           \
+            SREG = _idle_sreg;             \
+        }                                  \
+    } while (0)
+
+#endif  // _CALEBRJC_BSP_IDLE_H_
@@ -1,6 +1,7 @@
 #ifndef _CALEBRJC_BSP_IO_IO_H_
 #define _CALEBRJC_BSP_IO_IO_H_
 
+#include <avr/io.h>
 #include <stdint.h>
 
 /// @brief IO pins.
@@ -37,6 +38,19 @@ typedef uint8_t io_pin;
 #define BSP_PD6 0x16  // Port D, Pin 6
 #define BSP_PD7 0x17  // Port D, Pin 7
 
+/// @brief IO ports, for operating on several pins of a port at once. Pins are selected with an
+///        8-bit mask, in which bit n selects pin n of the port (see IO_PIN_MASK()).
+typedef enum {
+    /// @brief Port B (BSP_PB0 to BSP_PB7).
+    IO_PORT_B,
+
+    /// @brief Port C (BSP_PC0 to BSP_PC7).
+    IO_PORT_C,
+
+    /// @brief Port D (BSP_PD0 to BSP_PD7).
+    IO_PORT_D,
+} io_port;
+
 /// @brief The logic level of an IO pin.
 typedef enum {
     /// @brief Represents a logic low.
@@ -81,18 +95,235 @@ typedef struct {
 /// @param config The configuration to apply to the pin.
 void io_configure(io_pin pin, io_config config);
 
+/// @brief Configure several pins of an IO port at once.
+/// @param port The port of the pins.
+/// @param mask The pins to configure.
+/// @param config The configuration to apply to the pins.
+void io_configure_mask(io_port port, uint8_t mask, io_config config);
+
+// Inline implementation ---------------------------------------------------------------------------
+
+// Note:
+// io_read(), io_write(), io_toggle() and the port-wide functions are always inlined so that, when
+// the pin (or port) is a compile-time constant, the compiler resolves its registers and bit and the
+// call reduces to a single sbis/sbic test (io_read()), sbi/cbi (io_write()) or write to PINx
+// (io_toggle()), each of which is also interrupt-safe. Pins only known at runtime are handled out
+// of line by the *_dynamic() functions, which look the registers up in a table. Without
+// optimization, every call takes the table path.
+
+// Convenience macros for getting the port index, pin index and pin mask from a pin number
+#define IO_PORT_IDX(pin) (((pin) >> 3) & 0x03)
+#define IO_PIN_IDX(pin)  ((pin) & 0x07)
+#define IO_PIN_MASK(pin) ((uint8_t)_BV(IO_PIN_IDX(pin)))
+
+/// @brief The port of a pin, e.g. IO_PORT_B for BSP_PB5.
+#define IO_PIN_PORT(pin) ((io_port)IO_PORT_IDX(pin))
+
+// Writing ones to PINx toggles the matching PORTx bits on the ATmega328P. The simulated registers
+// are plain memory, so the host build toggles PORTx directly.
+#ifdef BSP_HOST_SIM
+#define IO_HW_TOGGLE(port_reg, pin_reg, mask) ((port_reg) ^= (mask))
+#else
+#define IO_HW_TOGGLE(port_reg, pin_reg, mask) ((pin_reg) = (mask))
+#endif
+
+#define IO_INLINE static inline __attribute__((always_inline))
+
+/// @brief Return the logic level of an IO pin, looking its register up at runtime.
+/// @param pin The pin to read.
+/// @return The logic level of an IO pin.
+io_logic_level io_read_dynamic(io_pin pin);
+
+/// @brief Write a logic level to an IO pin, looking its register up at runtime.
+/// @param pin The pin to write to.
+/// @param level The logic level to write.
+void io_write_dynamic(io_pin pin, io_logic_level level);
+
+/// @brief Toggle the logic level of an IO pin, looking its register up at runtime.
+/// @param pin The pin to toggle.
+void io_toggle_dynamic(io_pin pin);
+
 /// @brief Return the logic level of an IO pin.
 /// @param pin The pin to read.
 /// @return The logic level of an IO pin.
-io_logic_level io_read(io_pin pin);
+IO_INLINE io_logic_level io_read(io_pin pin) {
+    if (!__builtin_constant_p(pin)) return io_read_dynamic(pin);
+
+    switch (IO_PORT_IDX(pin)) {
+        case 0:
+            return (PINB & IO_PIN_MASK(pin)) ? IO_HIGH : IO_LOW;
+        case 1:
+            return (PINC & IO_PIN_MASK(pin)) ? IO_HIGH : IO_LOW;
+        case 2:
+            return (PIND & IO_PIN_MASK(pin)) ? IO_HIGH : IO_LOW;
+        default:
+            return io_read_dynamic(pin);
+    }
+}
 
 /// @brief Write a logic level to an IO pin.
 /// @param pin The pin to write to.
 /// @param level The logic level to write.
-void io_write(io_pin pin, io_logic_level level);
+IO_INLINE void io_write(io_pin pin, io_logic_level level) {
+    if (!__builtin_constant_p(pin)) {
+        io_write_dynamic(pin, level);
+        return;
+    }
+
+    switch (IO_PORT_IDX(pin)) {
+        case 0:
+            if (level == IO_HIGH) {
+                PORTB |= IO_PIN_MASK(pin);
+            } else {
+                PORTB &= (uint8_t)~IO_PIN_MASK(pin);
+            }
+            break;
+        case 1:
+            if (level == IO_HIGH) {
+                PORTC |= IO_PIN_MASK(pin);
+            } else {
+                PORTC &= (uint8_t)~IO_PIN_MASK(pin);
+            }
+            break;
+        case 2:
+            if (level == IO_HIGH) {
+                PORTD |= IO_PIN_MASK(pin);
+            } else {
+                PORTD &= (uint8_t)~IO_PIN_MASK(pin);
+            }
+            break;
+        default:
+            io_write_dynamic(pin, level);
+            break;
+    }
+}
 
 /// @brief Toggle the logic level of an IO pin.
 /// @param pin The pin to toggle.
-void io_toggle(io_pin pin);
+IO_INLINE void io_toggle(io_pin pin) {
+    if (!__builtin_constant_p(pin)) {
+        io_toggle_dynamic(pin);
+        return;
+    }
+
+    switch (IO_PORT_IDX(pin)) {
+        case 0:
+            IO_HW_TOGGLE(PORTB, PINB, IO_PIN_MASK(pin));
+            break;
+        case 1:
+            IO_HW_TOGGLE(PORTC, PINC, IO_PIN_MASK(pin));
+            break;
+        case 2:
+            IO_HW_TOGGLE(PORTD, PIND, IO_PIN_MASK(pin));
+            break;
+        default:
+            io_toggle_dynamic(pin);
+            break;
+    }
+}
+
+// Port-wide operations ----------------------------------------------------------------------------
+
+// Note:
+// Masked writes and toggles update every selected pin with a single write to PINx, so the pins
+// change in the same cycle. A masked toggle is a single write, but a masked write reads PORTx to
+// find the pins that need to change and then toggles exactly those. Pins outside the mask are never
+// written, so an interrupt that changes them between the read and the write is not undone; pins
+// inside the mask are not protected, though. If an interrupt changes one of them in between, the
+// toggle flips it again, leaving it at the opposite of value. Disable interrupts around a masked
+// write to pins that an interrupt handler also writes.
+
+/// @brief Return the logic levels of an IO port, looking its register up at runtime.
+/// @param port The port to read.
+/// @return The logic levels of the port's pins (bit n for pin n).
+uint8_t io_read_port_dynamic(io_port port);
+
+/// @brief Write logic levels to several pins of an IO port, looking its registers up at runtime.
+/// @param port The port to write to.
+/// @param mask The pins to write.
+/// @param value The logic levels to write (bit n for pin n); bits outside mask are ignored.
+void io_write_mask_dynamic(io_port port, uint8_t mask, uint8_t value);
+
+/// @brief Toggle several pins of an IO port, looking its registers up at runtime.
+/// @param port The port of the pins.
+/// @param mask The pins to toggle.
+void io_toggle_mask_dynamic(io_port port, uint8_t mask);
+
+/// @brief Return the logic levels of an IO port.
+/// @param port The port to read.
+/// @return The logic levels of the port's pins (bit n for pin n).
+IO_INLINE uint8_t io_read_port(io_port port) {
+    if (!__builtin_constant_p(port)) return io_read_port_dynamic(port);
+
+    switch (port) {
+        case IO_PORT_B:
+            return PINB;
+        case IO_PORT_C:
+            return PINC;
+        case IO_PORT_D:
+            return PIND;
+        default:
+            return io_read_port_dynamic(port);
+    }
+}
+
+/// @brief Write logic levels to several pins of an IO port at once. This is not atomic with
+///        respect to interrupts that write the same pins (see the note above).
+/// @param port The port to write to.
+/// @param mask The pins to write.
+/// @param value The logic levels to write (bit n for pin n); bits outside mask are ignored.
+IO_INLINE void io_write_mask(io_port port, uint8_t mask, uint8_t value) {
+    if (!__builtin_constant_p(port)) {
+        io_write_mask_dynamic(port, mask, value);
+        return;
+    }
+
+    switch (port) {
+        case IO_PORT_B:
+            IO_HW_TOGGLE(PORTB, PINB, (uint8_t)((PORTB ^ value) & mask));
+            break;
+        case IO_PORT_C:
+            IO_HW_TOGGLE(PORTC, PINC, (uint8_t)((PORTC ^ value) & mask));
+            break;
+        case IO_PORT_D:
+            IO_HW_TOGGLE(PORTD, PIND, (uint8_t)((PORTD ^ value) & mask));
+            break;
+        default:
+            io_write_mask_dynamic(port, mask, value);
+            break;
+    }
+}
+
+/// @brief Write logic levels to every pin of an IO port at once.
+/// @param port The port to write to.
+/// @param value The logic levels to write (bit n for pin n).
+IO_INLINE void io_write_port(io_port port, uint8_t value) {
+    io_write_mask(port, 0xFF, value);
+}
+
+/// @brief Toggle several pins of an IO port at once.
+/// @param port The port of the pins.
+/// @param mask The pins to toggle.
+IO_INLINE void io_toggle_mask(io_port port, uint8_t mask) {
+    if (!__builtin_constant_p(port)) {
+        io_toggle_mask_dynamic(port, mask);
+        return;
+    }
+
+    switch (port) {
+        case IO_PORT_B:
+            IO_HW_TOGGLE(PORTB, PINB, mask);
+            break;
+        case IO_PORT_C:
+            IO_HW_TOGGLE(PORTC, PINC, mask);
+            break;
+        case IO_PORT_D:
+            IO_HW_TOGGLE(PORTD, PIND, mask);
+            break;
+        default:
+            io_toggle_mask_dynamic(port, mask);
+            break;
+    }
+}
 
 #endif  // _CALEBRJC_BSP_IO_IO_H_
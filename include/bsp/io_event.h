@@ -0,0 +1,61 @@
+#ifndef _CALEBRJC_BSP_IO_EVENT_H_
+#define _CALEBRJC_BSP_IO_EVENT_H_
+
+#include <stdint.h>
+
+#include "bsp/io.h"
+
+/// @brief Edge events on IO pins.
+
+// Note:
+// BSP_PD2 and BSP_PD3 use the external interrupts INT0 and INT1, whose hardware edge detection
+// runs a single handler per edge. Every other pin uses its port's pin change interrupt (PCINT0 to
+// PCINT2), which fires on any change of any enabled pin of the port: its handler compares the port
+// with the previous snapshot, masks the result down to the registered edges and only calls the
+// callbacks of those pins. A pin change that is shorter than the handler's latency may be missed on
+// the PCINT pins, while INT0 and INT1 latch it in hardware.
+//
+// Estimated latency (counted from the instructions that the handlers should compile to; none of
+// these figures have been measured on hardware): from an edge to its callback, an estimated 60
+// cycles, or 4 us at 16 MHz, for INT0 and INT1. That estimate is 4 cycles of interrupt response, 3
+// for the vector's jump, about 32 for the prologue that saves the registers a callback may clobber,
+// and about 20 to post the scheduler event, load the callback and call it. For the PCINT pins, an
+// estimated 90 cycles to reach the callback of a port's pin 0, plus an estimated 9 for each pin
+// index stepped over to reach a higher pin. Handlers run one at a time, so an edge that arrives
+// while another interrupt is running also waits for it to return. To measure the latency, toggle
+// an output pin in the callback and compare it with the edge on a scope or logic analyzer.
+//
+// Callbacks are called from the interrupt handler, so they should be short. Every event also posts
+// SCHED_EVENT_IO_EDGE (see bsp/sched.h), so a pin can instead be registered without a callback and
+// handled by a scheduler task, which is the only way with the isr_callbacks meson option off.
+// Configure the pin as an input (see io_configure()) before registering it.
+
+/// @brief The edges of an IO pin that trigger an event.
+typedef enum {
+    /// @brief Low to high transitions.
+    IO_EDGE_RISING = 1,
+
+    /// @brief High to low transitions.
+    IO_EDGE_FALLING = 2,
+
+    /// @brief Both transitions.
+    IO_EDGE_BOTH = 3,
+} io_edge;
+
+/// @brief A function called when an edge event occurs on an IO pin.
+/// @param pin The pin on which the event occurred.
+/// @param level The logic level of the pin after the edge.
+typedef void (*io_event_callback)(io_pin pin, io_logic_level level);
+
+/// @brief Register a callback for edges on an IO pin, replacing any callback it already has, and
+///        enable the pin's interrupt.
+/// @param pin The pin to watch.
+/// @param edge The edges that trigger the callback.
+/// @param callback The callback function, or NULL to only post SCHED_EVENT_IO_EDGE.
+void io_event_register(io_pin pin, io_edge edge, io_event_callback callback);
+
+/// @brief Remove the callback of an IO pin, disabling its interrupt if no other pin needs it.
+/// @param pin The pin to stop watching.
+void io_event_unregister(io_pin pin);
+
+#endif  // _CALEBRJC_BSP_IO_EVENT_H_
@@ -0,0 +1,102 @@
+#ifndef _CALEBRJC_BSP_SCHED_H_
+#define _CALEBRJC_BSP_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief Cooperative run-to-completion scheduler.
+
+// Note:
+// Interrupt handlers (the BSP's and the application's) post event flags, and the scheduler runs
+// every task that waits for one of the posted events from the main loop, in table order, each to
+// completion. Once no events are pending, it waits for the next interrupt (see bsp/idle.h). A task
+// therefore runs at most one pass of the task table after its event was posted, and the time that
+// takes is bounded by the tasks' own run times, with no interrupt-context work beyond setting a
+// flag. Events posted while the tasks run are handled on the next pass; an event posted several
+// times before it is handled runs its tasks once.
+//
+// The BSP drivers post the SCHED_EVENT_* events below whether or not the scheduler is used (it
+// costs them a single OR), and applications define their own with SCHED_EVENT_USER().
+//
+// The drivers also keep their callbacks (e.g. usart_register_callback() and the SPI and I2C
+// on_complete callbacks), which run in the interrupt handlers, because applications written before
+// the scheduler rely on them and because some work cannot wait for the main loop, such as
+// resubmitting a transfer back to back. An application that handles everything in tasks can build
+// with the isr_callbacks meson option off (BSP_ISR_CALLBACKS=0): the handlers then only post events,
+// the callback calls are compiled out, and registering a callback fails an assert.
+
+/// @brief Whether the BSP drivers call application callbacks from their interrupt handlers (set by
+///        the isr_callbacks meson option).
+#ifndef BSP_ISR_CALLBACKS
+#define BSP_ISR_CALLBACKS 1
+#endif
+
+/// @brief A set of event flags.
+typedef uint16_t sched_events;
+
+/// @brief A byte was received on USART0.
+#define SCHED_EVENT_USART0_RX ((sched_events)(1U << 0))
+
+/// @brief A USART0 frame was completed (see usart_register_frame_callback()), or a valid frame was
+///        received with framing enabled (see usart_frame_read()).
+#define SCHED_EVENT_USART0_FRAME ((sched_events)(1U << 1))
+
+/// @brief The USART0 TX buffer became empty.
+#define SCHED_EVENT_USART0_TX_EMPTY ((sched_events)(1U << 2))
+
+/// @brief An edge event occurred on an IO pin watched by bsp/io_event.h.
+#define SCHED_EVENT_IO_EDGE ((sched_events)(1U << 3))
+
+/// @brief A debounced input changed (see bsp/debounce.h).
+#define SCHED_EVENT_DEBOUNCE ((sched_events)(1U << 4))
+
+/// @brief An SPI transfer completed (see bsp/spi.h).
+#define SCHED_EVENT_SPI ((sched_events)(1U << 5))
+
+/// @brief An I2C transaction completed or failed (see bsp/i2c.h).
+#define SCHED_EVENT_I2C ((sched_events)(1U << 6))
+
+/// @brief An application-defined event.
+/// @param n The number of the event, from 0 to 7.
+#define SCHED_EVENT_USER(n) ((sched_events)(1U << (8 + (n))))
+
+/// @brief A function that handles events.
+/// @param events The posted events that the task waits for.
+typedef void (*sched_task_fn)(sched_events events);
+
+/// @brief A task: the events it waits for, and the function that handles them.
+typedef struct {
+    /// @brief The events that the task waits for.
+    sched_events events;
+
+    /// @brief The function that handles them.
+    sched_task_fn run;
+} sched_task;
+
+/// @brief The pending events. Use sched_post() or sched_post_from_isr() instead of accessing this
+///        directly.
+extern volatile sched_events sched_pending;
+
+/// @brief Post events from an interrupt handler (where interrupts are already disabled).
+/// @param events The events to post.
+static inline void sched_post_from_isr(sched_events events) {
+    sched_pending |= events;
+}
+
+/// @brief Set the task table. Tasks run in table order, so put the most urgent first.
+/// @param tasks The tasks, which must outlive the scheduler.
+/// @param count The number of tasks.
+void sched_init(const sched_task *tasks, uint8_t count);
+
+/// @brief Post events from the main loop (or any other context).
+/// @param events The events to post.
+void sched_post(sched_events events);
+
+/// @brief Take the pending events and run every task that waits for one of them.
+/// @return True if any events were pending.
+bool sched_run_once(void);
+
+/// @brief Run tasks as events are posted, waiting for interrupts in between. Never returns.
+void sched_run(void);
+
+#endif  // _CALEBRJC_BSP_SCHED_H_
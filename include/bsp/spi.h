@@ -0,0 +1,140 @@
+#ifndef _CALEBRJC_BSP_SPI_H_
+#define _CALEBRJC_BSP_SPI_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bsp/io.h"
+
+/// @brief Interrupt-driven SPI master.
+
+// Note:
+// Transfers are described by spi_transfer descriptors, which the application owns and submits to a
+// queue (sized by the spi_queue_size meson option). The SPI interrupt exchanges one byte per
+// interrupt: it writes the next byte to SPDR before storing the one received, and when a transfer
+// ends it releases its chip select, completes it and starts the next queued transfer in the same
+// handler, so that queued transfers run back to back while the main loop does other work.
+//
+// Each byte costs an interrupt (a few dozen cycles), so at the fastest clocks the bus idles between
+// bytes while the handler runs; SPI_CLOCK_DIV_16 and slower keep it busy. The driver owns the SPI
+// pins (PB2 to PB5) and the SPI interrupt. PB2 (SS) is kept as an output, as master mode requires,
+// and may be used as a chip select.
+
+/// @brief The SPI clock rate, as a divider of the CPU clock. Each value encodes SPI2X in bit 2 and
+///        SPR1:SPR0 in bits 1:0.
+typedef enum {
+    SPI_CLOCK_DIV_2   = 0x04,
+    SPI_CLOCK_DIV_4   = 0x00,
+    SPI_CLOCK_DIV_8   = 0x05,
+    SPI_CLOCK_DIV_16  = 0x01,
+    SPI_CLOCK_DIV_32  = 0x06,
+    SPI_CLOCK_DIV_64  = 0x02,
+    SPI_CLOCK_DIV_128 = 0x03,
+} spi_clock;
+
+/// @brief The SPI mode: clock polarity (CPOL) in bit 1 and clock phase (CPHA) in bit 0.
+typedef enum {
+    /// @brief Clock idles low, data sampled on the rising edge.
+    SPI_MODE_0 = 0,
+
+    /// @brief Clock idles low, data sampled on the falling edge.
+    SPI_MODE_1 = 1,
+
+    /// @brief Clock idles high, data sampled on the falling edge.
+    SPI_MODE_2 = 2,
+
+    /// @brief Clock idles high, data sampled on the rising edge.
+    SPI_MODE_3 = 3,
+} spi_mode;
+
+/// @brief Configuration for the SPI.
+typedef struct {
+    /// @brief The clock rate.
+    spi_clock clock;
+
+    /// @brief The clock polarity and phase.
+    spi_mode mode;
+
+    /// @brief Whether to send the least significant bit of each byte first.
+    bool lsb_first;
+} spi_config;
+
+/// @brief The state of an SPI transfer.
+typedef enum {
+    /// @brief The transfer has not been submitted (or was not accepted).
+    SPI_STATUS_IDLE,
+
+    /// @brief The transfer is waiting in the queue.
+    SPI_STATUS_QUEUED,
+
+    /// @brief The transfer is in progress.
+    SPI_STATUS_ACTIVE,
+
+    /// @brief The transfer has completed.
+    SPI_STATUS_DONE,
+} spi_status;
+
+/// @brief The byte sent when a transfer has no TX buffer.
+#define SPI_FILL_BYTE 0xFF
+
+typedef struct spi_transfer spi_transfer;
+
+/// @brief A callback to be called when an SPI transfer completes.
+/// @param transfer The transfer that completed.
+typedef void (*spi_callback)(spi_transfer *transfer);
+
+/// @brief A full-duplex SPI transfer. The descriptor and its buffers must stay valid until the
+///        transfer completes.
+struct spi_transfer {
+    /// @brief The chip select of the device, which is driven low for the transfer. Configure it as
+    ///        an output, initially high, first.
+    io_pin cs_pin;
+
+    /// @brief Whether to keep the chip select low after the transfer, so that the next transfer
+    ///        (which must be for the same device) continues the same transaction, e.g. to send a
+    ///        command and then read its response.
+    bool cs_hold;
+
+    /// @brief The bytes to send, or NULL to send SPI_FILL_BYTE.
+    const uint8_t *tx_buf;
+
+    /// @brief The buffer to store the bytes received in, or NULL to discard them. It may be the
+    ///        same buffer as tx_buf.
+    uint8_t *rx_buf;
+
+    /// @brief The number of bytes to exchange (at least 1).
+    uint16_t length;
+
+    /// @brief The function to call when the transfer completes, or NULL (which builds with the
+    ///        isr_callbacks meson option off require; see bsp/sched.h).
+    spi_callback on_complete;
+
+    /// @brief Application data for on_complete.
+    void *context;
+
+    /// @brief The state of the transfer (written by the driver).
+    volatile spi_status status;
+};
+
+/// @brief Initialize the SPI as a master.
+/// @param config The configuration to use.
+void spi_init(spi_config config);
+
+/// @brief Queue a transfer, starting it at once if the SPI is idle. Completion posts
+///        SCHED_EVENT_SPI (see bsp/sched.h) and calls the transfer's on_complete callback in an
+///        interrupt context, after starting the next queued transfer; callbacks may submit further
+///        transfers.
+/// @param transfer The transfer to queue.
+/// @return True if the transfer was queued, or false if the queue is full.
+bool spi_submit(spi_transfer *transfer);
+
+/// @brief Queue a transfer and wait (see bsp/idle.h) until it completes, including for room in the
+///        queue.
+/// @param transfer The transfer to run.
+void spi_transfer_blocking(spi_transfer *transfer);
+
+/// @brief Return true if the SPI has transfers in progress or queued.
+/// @return True if the SPI is busy.
+bool spi_busy(void);
+
+#endif  // _CALEBRJC_BSP_SPI_H_
@@ -3,40 +3,303 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "bsp/io.h"
+
 /// @brief USART peripherals.
 
 typedef uint8_t usart;
 
 #define BSP_USART0 0x00
 
-/// @brief Baud rates for the USART.
+/// @brief Common baud rates for the USART. Any other rate may be used as well.
 typedef enum {
-    USART_BAUD_INVALID = 0U,
-    USART_BAUD_9600    = 9600U,
-    USART_BAUD_19200   = 19200U,
-    USART_BAUD_38400   = 38400U,
-    USART_BAUD_57600   = 57600U,
-    USART_BAUD_115200  = 115200U,
+    USART_BAUD_INVALID = 0UL,
+    USART_BAUD_9600    = 9600UL,
+    USART_BAUD_19200   = 19200UL,
+    USART_BAUD_38400   = 38400UL,
+    USART_BAUD_57600   = 57600UL,
+    USART_BAUD_115200  = 115200UL,
+    USART_BAUD_230400  = 230400UL,
+    USART_BAUD_250000  = 250000UL,
+    USART_BAUD_500000  = 500000UL,
+    USART_BAUD_1000000 = 1000000UL,
 } usart_baud_rate;
 
+/// @brief The baud rate register setting for a baud rate.
+typedef struct {
+    /// @brief The value for the baud rate register (UBRR0).
+    uint16_t ubrr;
+
+    /// @brief Whether the USART runs in double speed mode (U2X0).
+    bool double_speed;
+
+    /// @brief The difference between the achieved and the requested baud rate, in hundredths of a
+    ///        percent of the requested rate (e.g. -350 means the USART runs 3.5% slow). Saturates
+    ///        at INT16_MIN/INT16_MAX for rates the USART cannot get close to.
+    int16_t error;
+} usart_baud_setting;
+
+/// @brief The largest baud rate error, in hundredths of a percent, that usart_init() accepts. The
+///        receiver tolerates a total error of about +4.3%/-3.6% for 8-bit frames (see the
+///        datasheet's asynchronous operational range), shared with the other end's clock; 3% leaves
+///        some of it to the other end, and admits the 2.1% of 115200 baud at 16 MHz.
+#define USART_BAUD_MAX_ERROR 300
+
+/// @brief What a write does when the TX buffer is full.
+typedef enum {
+    /// @brief Wait until there is space in the TX buffer.
+    USART_FULL_POLICY_BLOCK,
+
+    /// @brief Return immediately, dropping the data that did not fit.
+    USART_FULL_POLICY_DROP_NEW,
+
+    /// @brief Discard the oldest data in the TX buffer to make room for the new data.
+    USART_FULL_POLICY_OVERWRITE_OLDEST,
+
+    /// @brief Wait until there is space in the TX buffer, but no longer than tx_timeout_us in total
+    ///        per call, then drop the data that did not fit. The timeout is measured with
+    ///        bsp_micros(), so clock_init() must have been called.
+    USART_FULL_POLICY_BLOCK_TIMEOUT,
+} usart_full_policy;
+
+/// @brief Why a frame of received data was completed.
+typedef enum {
+    /// @brief The delimiter was received (it is the last byte of the frame).
+    USART_RX_EVENT_DELIMITER,
+
+    /// @brief The frame reached the threshold length.
+    USART_RX_EVENT_THRESHOLD,
+
+    /// @brief The line went idle (see usart_rx_tick()).
+    USART_RX_EVENT_IDLE,
+} usart_rx_event;
+
+/// @brief How received data is split into frames, and how frames are sent.
+typedef enum {
+    /// @brief No framing: bytes are received into the RX buffer as they arrive.
+    USART_FRAMING_NONE,
+
+    /// @brief Consistent Overhead Byte Stuffing: frames contain no zero bytes, and each is followed
+    ///        by a zero byte.
+    USART_FRAMING_COBS,
+
+    /// @brief SLIP (RFC 1055): frames end with 0xC0, and 0xC0 and 0xDB in the data are escaped as
+    ///        0xDB 0xDC and 0xDB 0xDD.
+    USART_FRAMING_SLIP,
+} usart_framing;
+
+/// @brief RTS/CTS hardware flow control. Both signals are active low, and each may be used without
+///        the other.
+typedef struct {
+    /// @brief Whether to drive rts_pin to tell the sender when to pause.
+    bool rts_enabled;
+
+    /// @brief The output that tells the sender to pause (RTS): it is driven high once the RX buffer
+    ///        holds rts_high_water bytes, and low again once the application has read it down to
+    ///        half of that.
+    io_pin rts_pin;
+
+    /// @brief The number of bytes in the RX buffer at which RTS is deasserted, leaving room for the
+    ///        bytes the sender sends before it reacts, or 0 for three quarters of the RX buffer.
+    uint8_t rts_high_water;
+
+    /// @brief Whether to pause transmission while cts_pin is high.
+    bool cts_enabled;
+
+    /// @brief The input that tells the USART to pause (CTS). It must be driven by the receiver, and
+    ///        its edges are watched with bsp/io_event.h, which it must not otherwise be registered
+    ///        with. The byte being shifted out when it goes high is still sent.
+    io_pin cts_pin;
+} usart_flow_control;
+
 /// @brief Configuration for the USART.
 typedef struct {
-    /// @brief The baud rate to use.
-    usart_baud_rate baud_rate;
+    /// @brief The baud rate to use, in bits per second (e.g. a usart_baud_rate). It must be within
+    ///        USART_BAUD_MAX_ERROR of a rate that the USART can produce (see usart_baud_valid()).
+    uint32_t baud_rate;
 
     /// @brief Whether or not to echo received characters. If true, all characters received will be
     ///        echoed back to the sender regardless of whether or not the character was read by
     ///        usart_read(), meaning that the user will see the characters sent to the USART device,
     ///        not the characters acknowledged by the application, and that characters will be
-    ///        echoed until the RX buffer is full. If false, no characters will be echoed.
+    ///        echoed until the RX buffer is full. If false, no characters will be echoed. Echoing
+    ///        never waits for the TX buffer: echoed characters are sent ahead of buffered output,
+    ///        and are dropped (see usart_stats.echo_dropped) if the transmitter falls behind.
     bool echo_on_recv;
+
+    /// @brief What writes do when the TX buffer is full (blocking by default).
+    usart_full_policy tx_full_policy;
+
+    /// @brief The longest a single write may wait for space in the TX buffer, in microseconds, when
+    ///        tx_full_policy is USART_FULL_POLICY_BLOCK_TIMEOUT.
+    uint32_t tx_timeout_us;
+
+    /// @brief Storage for the RX buffer, or NULL to use the BSP's default buffer (whose size is set
+    ///        by the usart0_rx_buffer_size meson option). The storage must stay valid for as long as
+    ///        the USART is in use, e.g. a static array.
+    char *rx_buffer;
+
+    /// @brief The size of rx_buffer, in bytes. Must be a power of two no greater than 128.
+    uint8_t rx_buffer_size;
+
+    /// @brief Storage for the TX buffer, or NULL to use the BSP's default buffer (whose size is set
+    ///        by the usart0_tx_buffer_size meson option). The storage must stay valid for as long as
+    ///        the USART is in use, e.g. a static array.
+    char *tx_buffer;
+
+    /// @brief The size of tx_buffer, in bytes. Must be a power of two no greater than 128, or 0 for
+    ///        an application that never transmits (writes then send nothing and return at once).
+    uint8_t tx_buffer_size;
+
+    /// @brief Whether rx_delimiter ends frames (and lines, for usart_readline()). The last free
+    ///        byte of the RX buffer is then kept for a delimiter, so that a line too long for the
+    ///        buffer is cut short instead of losing its delimiter.
+    bool rx_delimiter_enabled;
+
+    /// @brief The byte that ends a frame, e.g. '\r' or '\n'.
+    char rx_delimiter;
+
+    /// @brief The number of bytes after which a frame is completed, or 0 for no threshold.
+    uint8_t rx_threshold;
+
+    /// @brief The number of usart_rx_tick() calls without received data after which a partial
+    ///        frame is completed, or 0 to disable idle detection.
+    uint8_t rx_idle_ticks;
+
+    /// @brief How received data is framed (see usart_frame_read()). With COBS or SLIP framing, the
+    ///        RX buffer holds decoded frames instead of raw bytes, and echo_on_recv, the delimiter,
+    ///        the threshold, idle detection and the receive callbacks do not apply.
+    usart_framing framing;
+
+    /// @brief Hardware flow control (none by default).
+    usart_flow_control flow_control;
 } usart_config;
 
+/// @brief Calculate the baud rate register setting closest to a baud rate, choosing between normal
+///        and double speed mode to minimize the error. With constant arguments (e.g.
+///        usart_baud_calculate(F_CPU, USART_BAUD_115200)) this folds to a compile-time constant.
+/// @param f_cpu The CPU frequency, in Hz.
+/// @param baud_rate The requested baud rate, in bits per second.
+/// @return The baud rate register setting.
+static inline usart_baud_setting usart_baud_calculate(uint32_t f_cpu, uint32_t baud_rate) {
+    usart_baud_setting best = {.error = INT16_MAX};
+    int32_t best_magnitude  = INT32_MAX;
+
+    if (baud_rate == 0) return best;
+
+    // Try normal mode (16 samples per bit), then double speed mode (8 samples per bit); normal mode
+    // wins ties because the receiver tolerates more error with more samples
+    for (uint8_t samples = 16; samples >= 8; samples /= 2) {
+        // Round to the nearest divisor, and clamp it to what the 12-bit register can hold
+        uint32_t divisor = (f_cpu + (samples * baud_rate) / 2) / (samples * baud_rate);
+        if (divisor < 1) divisor = 1;
+        if (divisor > 4096) divisor = 4096;
+
+        uint32_t actual = (f_cpu + (samples * divisor) / 2) / (samples * divisor);
+        int32_t diff    = (int32_t)actual - (int32_t)baud_rate;
+
+        // Compute the error in hundredths of a percent, saturating instead of overflowing
+        int32_t error;
+        if (diff > 200000L || diff < -200000L) {
+            error = (diff > 0) ? INT16_MAX : INT16_MIN;
+        } else {
+            error = (diff * 10000L) / (int32_t)baud_rate;
+        }
+
+        if (error > INT16_MAX) error = INT16_MAX;
+        if (error < INT16_MIN) error = INT16_MIN;
+
+        int32_t magnitude = (diff < 0) ? -diff : diff;
+        if (magnitude < best_magnitude) {
+            best_magnitude    = magnitude;
+            best.ubrr         = (uint16_t)(divisor - 1);
+            best.double_speed = (samples == 8);
+            best.error        = (int16_t)error;
+        }
+    }
+
+    return best;
+}
+
+/// @brief Return true if a baud rate register setting is within USART_BAUD_MAX_ERROR of the
+///        requested rate.
+/// @param setting The baud rate register setting (see usart_baud_calculate()).
+/// @return True if the setting is usable.
+static inline bool usart_baud_valid(usart_baud_setting setting) {
+    return setting.error >= -USART_BAUD_MAX_ERROR && setting.error <= USART_BAUD_MAX_ERROR;
+}
+
+/// @brief Return the baud rate register setting in use, including the error of the achieved baud
+///        rate.
+/// @param device The USART to query.
+/// @return The baud rate register setting in use.
+usart_baud_setting usart_get_baud_setting(usart device);
+
+/// @brief Health and performance counters for the USART. Counters wrap around on overflow.
+typedef struct {
+    /// @brief The number of bytes received from the line (including dropped bytes).
+    uint32_t rx_bytes;
+
+    /// @brief The number of bytes transmitted on the line.
+    uint32_t tx_bytes;
+
+    /// @brief The number of data overruns detected by the hardware (DOR0), i.e. bytes lost because
+    ///        the RX interrupt was not serviced in time.
+    uint16_t rx_overrun_errors;
+
+    /// @brief The number of bytes received with a framing error (FE0).
+    uint16_t rx_framing_errors;
+
+    /// @brief The number of bytes received with a parity error (UPE0).
+    uint16_t rx_parity_errors;
+
+    /// @brief The number of received bytes dropped because the RX buffer was full.
+    uint16_t rx_dropped;
+
+    /// @brief The number of bytes dropped or overwritten because the TX buffer was full.
+    uint16_t tx_dropped;
+
+    /// @brief The number of times a write waited for space in the TX buffer.
+    uint16_t tx_blocked;
+
+    /// @brief The number of echoed bytes dropped because the transmitter was busy.
+    uint16_t echo_dropped;
+
+    /// @brief The number of valid frames received (see usart_frame_read()).
+    uint16_t rx_frames;
+
+    /// @brief The number of frames received with a CRC, encoding or line error.
+    uint16_t rx_frame_errors;
+
+    /// @brief The number of frames dropped because the RX buffer or the frame queue was full.
+    uint16_t rx_frames_dropped;
+
+    /// @brief The number of times RTS was deasserted because the RX buffer reached its high-water
+    ///        mark.
+    uint16_t rx_throttled;
+
+    /// @brief The number of times transmission paused because CTS was deasserted.
+    uint16_t tx_paused;
+
+    /// @brief The largest number of bytes seen in the RX buffer.
+    uint8_t rx_high_water;
+
+    /// @brief The largest number of bytes seen in the TX buffer.
+    uint8_t tx_high_water;
+} usart_stats;
+
 /// @brief A callback to be called when a character is received.
 typedef void (*usart_recv_callback)(void);
 
+/// @brief A callback to be called when a frame of received data is complete.
+/// @param event Why the frame was completed.
+/// @param length The number of bytes in the frame, which are waiting in the RX buffer (at most
+///        UINT8_MAX, for longer frames).
+typedef void (*usart_frame_callback)(usart_rx_event event, uint8_t length);
+
 /// @brief Initialize the USART.
 /// @param device The USART to initialize.
 /// @param config The configuration to use.
@@ -47,36 +310,191 @@ void usart_init(usart device, usart_config config);
 /// @return True if the USART has a character to read.
 bool usart_poll(usart device);
 
-/// @brief Return a character read from the USART.
+/// @brief Return a character read from the USART, waiting for one (see bsp/idle.h) if necessary.
 /// @param device The USART to read from.
 /// @return A character read the from USART.
 char usart_read(usart device);
 
-/// @brief Write a character to the USART.
+/// @brief Return a character read from the USART, waiting (see bsp/idle.h) up to timeout_ms for
+///        one if necessary. The timeout is measured with bsp_millis(), so clock_init() must have
+///        been called.
+/// @param device The USART to read from.
+/// @param timeout_ms The longest time to wait, in milliseconds.
+/// @return The character read (as an unsigned byte), or -1 if none arrived in time.
+int16_t usart_read_timeout(usart device, uint16_t timeout_ms);
+
+/// @brief Read a line (terminated by the configured rx_delimiter) from the USART, without waiting
+///        for one to arrive. The line is stored without its delimiter and NUL-terminated, and is
+///        truncated to fit o_buf (the rest of the line is discarded). A line that did not fit in the
+///        RX buffer is returned cut short, as far as the buffer held it. Lines are counted as their
+///        delimiters arrive, so this should not be mixed with other reads.
+/// @param device The USART to read from.
+/// @param o_buf The buffer to store the line in.
+/// @param len The size of o_buf, including the NUL terminator.
+/// @return The length of the stored line, or -1 if no complete line has been received.
+int16_t usart_readline(usart device, char *o_buf, size_t len);
+
+/// @brief Write a character to the USART. A full TX buffer is handled according to the configured
+///        tx_full_policy.
 /// @param device The USART to write to.
 /// @param c The character to write to the USART.
 void usart_write(usart device, char c);
 
+/// @brief Read up to len bytes from the USART without waiting for more data to arrive.
+/// @param device The USART to read from.
+/// @param o_buf The buffer to store the bytes read in.
+/// @param len The maximum number of bytes to read.
+/// @return The number of bytes read.
+size_t usart_read_buf(usart device, char *o_buf, size_t len);
+
+/// @brief Write a buffer to the USART. Unlike usart_write(), the bytes are sent as-is (newlines are
+///        not translated), and a full TX buffer is handled according to the configured
+///        tx_full_policy.
+/// @param device The USART to write to.
+/// @param buf The bytes to write.
+/// @param len The number of bytes to write.
+/// @return The number of bytes accepted into the TX buffer.
+size_t usart_write_buf(usart device, const char *buf, size_t len);
+
 /// @brief Output a character to the USART.
 /// @param c The character to output.
 void _putchar(char c);
 
-/// @brief Output a formatted string to the USART.
+/// @brief The size of the stack buffer that usart_printf() formats into, and so the size of the
+///        chunks that it enqueues output in and the size limit (including the NUL terminator) on
+///        usart_printf_P() formats (set by the usart_printf_buffer_size meson option).
+#ifndef USART_PRINTF_BUFFER_SIZE
+#define USART_PRINTF_BUFFER_SIZE 64
+#endif
+
+/// @brief Output a formatted string to the USART. Newlines are sent as "\r\n", as with
+///        usart_write(). The output is formatted once, into a stack buffer (of the
+///        usart_printf_buffer_size meson option) that is enqueued in bulk each time that it fills
+///        up, so it can be of any length.
 /// @param device The USART to output to.
 /// @param format The format string to output.
 /// @param ... The arguments to the format string.
-void usart_printf(usart device, const char* format, ...);
+/// @return The number of bytes accepted into the TX buffer, or a negative value on a formatting
+///         error.
+int usart_printf(usart device, const char* format, ...);
 
-/// @brief Output a formatted string to the USART.
+/// @brief Output a formatted string to the USART (see usart_printf()).
 /// @param device The USART to output to.
 /// @param format The format string to output.
 /// @param args The arguments to the format string.
-void usart_vprintf(usart device, const char* format, va_list args);
+/// @return The number of bytes accepted into the TX buffer, or a negative value on a formatting
+///         error.
+int usart_vprintf(usart device, const char* format, va_list args);
+
+/// @brief Like usart_printf(), with the format string in flash (e.g. from PSTR()), so that it takes
+///        no SRAM outside of the call. The format is copied into the end of the same stack buffer
+///        that the output is formatted into, so it must be shorter than the
+///        usart_printf_buffer_size meson option (63 characters by default), and the output is
+///        enqueued in chunks of the space that it leaves; a longer format is rejected without
+///        output.
+/// @param device The USART to output to.
+/// @param format The format string to output, in flash.
+/// @param ... The arguments to the format string.
+/// @return The number of bytes accepted into the TX buffer, or a negative value on a formatting
+///         error or a format that is too long.
+int usart_printf_P(usart device, const char* format, ...);
+
+/// @brief Output a formatted string to the USART, with the format string in flash (see
+///        usart_printf_P()).
+/// @param device The USART to output to.
+/// @param format The format string to output, in flash.
+/// @param args The arguments to the format string.
+/// @return The number of bytes accepted into the TX buffer, or a negative value on a formatting
+///         error or a format that is too long.
+int usart_vprintf_P(usart device, const char* format, va_list args);
+
+/// @brief Return the USART's health and performance counters. Counting is only compiled in when the
+/// usart_stats meson option is enabled; otherwise, all counters read as zero.
+/// @param device The USART to query.
+/// @return A snapshot of the USART's counters.
+usart_stats usart_get_stats(usart device);
+
+/// @brief Reset the USART's health and performance counters to zero.
+/// @param device The USART whose counters to reset.
+void usart_reset_stats(usart device);
+
+/// @brief Turn echoing of received characters on or off (see usart_config.echo_on_recv).
+/// @param device The USART to configure.
+/// @param echo_on_recv Whether to echo received characters.
+void usart_set_echo(usart device, bool echo_on_recv);
+
+/// @brief Change what writes do when the TX buffer is full (see usart_config.tx_full_policy).
+/// @param device The USART to configure.
+/// @param policy The policy for writes that do not fit.
+/// @param timeout_us The longest a write may wait, with USART_FULL_POLICY_BLOCK_TIMEOUT.
+void usart_set_tx_full_policy(usart device, usart_full_policy policy, uint32_t timeout_us);
+
+// Note:
+// With COBS or SLIP framing, the RX interrupt decodes each frame and checks its CRC as the bytes
+// arrive, staging the decoded payload in the RX buffer. Only a frame with a valid CRC is enqueued
+// (and posts SCHED_EVENT_USART0_FRAME), so the main loop never sees partial or corrupt frames and
+// reads each one with a single usart_frame_read() call. A frame's payload, followed by 2 bytes for
+// the CRC, must fit in the RX buffer, and up to 4 frames can wait to be read.
+//
+// On the line, a frame is its payload followed by the CRC-16/CCITT-FALSE of the payload (polynomial
+// 0x1021, initial value 0xFFFF, most significant byte first), encoded as a whole and followed by
+// the framing's delimiter.
+
+/// @brief Change how received data is framed (see usart_config.framing). Any data waiting in the RX
+///        buffer is discarded.
+/// @param device The USART to configure.
+/// @param framing The framing to use.
+void usart_set_framing(usart device, usart_framing framing);
+
+/// @brief Return true if the USART has a received frame to read.
+/// @param device The USART to check.
+/// @return True if the USART has a received frame to read.
+bool usart_frame_poll(usart device);
+
+/// @brief Read a received frame from the USART, without waiting for one to arrive. The frame is
+///        truncated to fit o_buf (the rest of the frame is discarded).
+/// @param device The USART to read from.
+/// @param o_buf The buffer to store the frame's payload in.
+/// @param len The size of o_buf.
+/// @return The length of the frame's payload (which may be more than len), or -1 if no frame has
+///         been received.
+int16_t usart_frame_read(usart device, void *o_buf, size_t len);
+
+/// @brief Encode a frame into the TX buffer, with its CRC and the configured framing. A full TX
+///        buffer is handled according to the configured tx_full_policy; if a frame is cut short,
+///        the receiver rejects it, and the next frame starts with an extra delimiter so that the
+///        receiver can resynchronize.
+/// @param device The USART to write to.
+/// @param payload The payload of the frame.
+/// @param len The length of the payload.
+/// @return True if the whole frame was accepted into the TX buffer.
+bool usart_frame_write(usart device, const void *payload, size_t len);
+
+/// @brief Change the USART's hardware flow control (see usart_config.flow_control). Pins that are no
+///        longer used are left as they are, except that RTS is left asserted.
+/// @param device The USART to configure.
+/// @param flow_control The flow control to use.
+void usart_set_flow_control(usart device, usart_flow_control flow_control);
 
 /// @brief Register a callback to be called when a character is received. Note: The registered
-/// callback will be called in an interrupt context.
+/// callback will be called in an interrupt context. Builds with the isr_callbacks meson option off
+/// do not call callbacks (see bsp/sched.h), and only accept NULL.
 /// @param device The USART to register the callback for.
 /// @param callback The callback to register.
 void usart_register_callback(usart device, usart_recv_callback on_character_recv);
 
+/// @brief Register a callback to be called when a frame of received data is complete, i.e. when the
+/// configured delimiter arrives, the threshold length is reached, or the line goes idle. Note: The
+/// registered callback will be called in an interrupt context (or in the context that calls
+/// usart_rx_tick(), for idle frames). Builds with the isr_callbacks meson option off do not call
+/// callbacks (see bsp/sched.h), and only accept NULL.
+/// @param device The USART to register the callback for.
+/// @param on_frame_recv The callback to register.
+void usart_register_frame_callback(usart device, usart_frame_callback on_frame_recv);
+
+/// @brief Advance idle detection on the USART by one tick. Call this periodically (e.g. from a
+/// timer) when rx_idle_ticks is set; the tick period sets the resolution of the idle gap.
+/// @param device The USART to tick.
+void usart_rx_tick(usart device);
+
 #endif  // _CALEBRJC_BSP_USART_USART_H_
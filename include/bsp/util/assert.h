@@ -1,14 +1,82 @@
 #ifndef _CALEBRJC_BSP_UTIL_ASSERT_H_
 #define _CALEBRJC_BSP_UTIL_ASSERT_H_
 
-#define bsp_assert(condition, msg_fmt, ...) \
-    ((condition) ? (void)0 : assert_handler(__FILE__, __LINE__, msg_fmt, ##__VA_ARGS__))
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+// Note:
+// Assert file names and messages are kept in flash (PSTR()) rather than being copied into SRAM at
+// startup, so msg_fmt must be a string literal. PSTR() keeps a copy of the file name at each assert
+// (the toolchain may merge them); with the assert_file_id meson option, asserts keep neither file
+// names nor messages: a failure reports only the ID of the source file (BSP_ASSERT_FILE_ID) and the
+// line.
+
+/// @brief The ID reported for asserts in the current source file in the assert_file_id build mode.
+///        Define it before any #include in a source file; BSP sources use IDs 1-127, leaving
+///        128-255 to applications. Files that do not define it report 0.
+#ifndef BSP_ASSERT_FILE_ID
+#define BSP_ASSERT_FILE_ID 0
+#endif
+
+// IDs of the BSP source files
+#define BSP_ASSERT_FILE_ID_USART    1
+#define BSP_ASSERT_FILE_ID_DEBOUNCE 2
+#define BSP_ASSERT_FILE_ID_SPI      3
+#define BSP_ASSERT_FILE_ID_I2C      4
+
+// Assert levels, chosen by the assert_level meson option
+#define BSP_ASSERT_LEVEL_OFF   0  // No asserts are checked
+#define BSP_ASSERT_LEVEL_FATAL 1  // Only bsp_assert() is checked
+#define BSP_ASSERT_LEVEL_FULL  2  // bsp_assert() and bsp_assert_debug() are checked
+
+#ifndef BSP_ASSERT_LEVEL
+#define BSP_ASSERT_LEVEL BSP_ASSERT_LEVEL_FULL
+#endif
+
+#if BSP_ASSERT_FILE_ID_ONLY
+#define bsp_assert_check(condition, msg_fmt, ...) \
+    ((condition) ? (void)0 : assert_handler_id(BSP_ASSERT_FILE_ID, __LINE__))
+#else
+#define bsp_assert_check(condition, msg_fmt, ...) \
+    ((condition) ? (void)0                        \
+                 : assert_handler_P(PSTR(__FILE__), __LINE__, PSTR(msg_fmt), ##__VA_ARGS__))
+#endif
+
+// An assert that is compiled out still has to compile, but its condition is never evaluated
+#define bsp_assert_ignore(condition, msg_fmt, ...) ((void)sizeof(condition))
+
+/// @brief Assert a condition that must hold even in production builds (checked unless asserts are
+///        off).
+#if BSP_ASSERT_LEVEL >= BSP_ASSERT_LEVEL_FATAL
+#define bsp_assert(condition, msg_fmt, ...) bsp_assert_check(condition, msg_fmt, ##__VA_ARGS__)
+#else
+#define bsp_assert(condition, msg_fmt, ...) bsp_assert_ignore(condition, msg_fmt)
+#endif
+
+/// @brief Assert a condition that is only worth checking in debug builds, e.g. on hot paths
+///        (checked at the full assert level only).
+#if BSP_ASSERT_LEVEL >= BSP_ASSERT_LEVEL_FULL
+#define bsp_assert_debug(condition, msg_fmt, ...) \
+    bsp_assert_check(condition, msg_fmt, ##__VA_ARGS__)
+#else
+#define bsp_assert_debug(condition, msg_fmt, ...) bsp_assert_ignore(condition, msg_fmt)
+#endif
 
 /// @brief Asserts that the given condition is true.
-/// @param condition The condition to assert.
 /// @param file The file in which the assertion is being made.
 /// @param line The line number at which the assertion is being made.
 /// @param msg_fmt The format of the message to print if the condition is false.
 void assert_handler(const char* file, int line, const char* msg_fmt, ...);
 
+/// @brief Like assert_handler(), with the file name and message format in flash.
+/// @param file The file in which the assertion is being made, in flash.
+/// @param line The line number at which the assertion is being made.
+/// @param msg_fmt The format of the message to print if the condition is false, in flash.
+void assert_handler_P(const char* file, int line, const char* msg_fmt, ...);
+
+/// @brief Like assert_handler(), reporting only a file ID (see BSP_ASSERT_FILE_ID) and line.
+/// @param file_id The ID of the file in which the assertion is being made.
+/// @param line The line number at which the assertion is being made.
+void assert_handler_id(uint8_t file_id, int line);
+
 #endif  // _CALEBRJC_BSP_UTIL_ASSERT_H_
@@ -0,0 +1,72 @@
+#ifndef _CALEBRJC_BSP_UTIL_LOG_H_
+#define _CALEBRJC_BSP_UTIL_LOG_H_
+
+#include <stdint.h>
+
+/// @brief Logging over USART0.
+
+// Note:
+// In the default (text) mode, bsp_log() is a thin wrapper around usart_printf_P(), so its formats
+// are limited to USART_PRINTF_BUFFER_SIZE bytes (including the NUL terminator). In binary mode (the
+// log_binary meson option), the MCU does no formatting at all: each call sends a compact record
+// containing the address of its format string in flash, a timestamp and the raw bytes of its
+// arguments, and tools/bsp_log_decode.py turns the records back into text on the host, using the
+// format strings stored in the firmware ELF. Format strings live in flash only, never in SRAM.
+//
+// Record layout (multi-byte fields are little-endian):
+// [ LOG_RECORD_SYNC | length (of the rest) | format address (2) | timestamp (4) | arguments... ]
+//
+// Arguments are encoded as the C type their conversion reads: int (also for the h, z and t length
+// modifiers), long, long long, double or pointer sized, per the target ABI; one byte for %c; and
+// the characters of a string plus its NUL terminator for %s. Arguments that do not fit in
+// LOG_RECORD_MAX_SIZE are left out.
+
+/// @brief The first byte of every binary log record.
+#define LOG_RECORD_SYNC 0xA5
+
+/// @brief The maximum size of a binary log record, in bytes.
+#define LOG_RECORD_MAX_SIZE 64
+
+#if BSP_LOG_BINARY
+
+// Format strings are placed in flash (".progmem" sections end up in .text on the AVR)
+#define LOG_FORMAT_ATTRIBUTES __attribute__((section(".progmem.bsp_log"), used))
+
+/// @brief Log a message with a printf-style format string, which must be a string literal.
+#define bsp_log(format, ...)                                                \
+    do {                                                                    \
+        static const char _bsp_log_format[] LOG_FORMAT_ATTRIBUTES = format; \
+        log_write_record(_bsp_log_format, ##__VA_ARGS__);                   \
+    } while (0)
+
+#else
+
+#include <avr/pgmspace.h>
+
+#include "bsp/usart.h"
+
+/// @brief Log a message with a printf-style format string, which must be a string literal. The
+///        format must fit usart_printf_P()'s stack copy, which is checked at compile time rather
+///        than leaving a longer format to be rejected without output.
+#define bsp_log(format, ...)                                                         \
+    do {                                                                             \
+        _Static_assert(sizeof(format) <= USART_PRINTF_BUFFER_SIZE,                   \
+                       "bsp_log() format is too long for usart_printf_buffer_size"); \
+        (void)usart_printf_P(BSP_USART0, PSTR(format), ##__VA_ARGS__);               \
+    } while (0)
+
+#endif
+
+/// @brief A function returning the current time, in whatever unit the application chooses.
+typedef uint32_t (*log_timestamp_source)(void);
+
+/// @brief Send a binary log record. Use bsp_log() instead of calling this directly.
+/// @param format The format string, in flash.
+/// @param ... The arguments to the format string.
+void log_write_record(const char *format, ...);
+
+/// @brief Set the function used to timestamp binary log records (records are stamped 0 otherwise).
+/// @param source The timestamp source, or NULL for none.
+void log_set_timestamp_source(log_timestamp_source source);
+
+#endif  // _CALEBRJC_BSP_UTIL_LOG_H_
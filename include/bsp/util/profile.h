@@ -0,0 +1,82 @@
+#ifndef _CALEBRJC_BSP_UTIL_PROFILE_H_
+#define _CALEBRJC_BSP_UTIL_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @brief Cycle-counting profiler for named regions of code.
+
+// Note:
+// Each region keeps the number of times it ran and its minimum, maximum and total length in CPU
+// cycles, as measured by bsp_cycles() (so clock_init() must have been called). The measurement
+// includes the overhead of bsp_profile_begin() and bsp_profile_end() themselves, which is the
+// minimum of an empty region. Regions add themselves to the list printed by profile_dump() the
+// first time they end. Without the profiling meson option, the macros compile to nothing.
+//
+// PROFILE_REGION_DEFINE(uart_rx);
+//
+// void poll(void) {
+//     bsp_profile_begin(uart_rx);
+//     ...
+//     bsp_profile_end(uart_rx);
+// }
+
+/// @brief The statistics of a profiled region.
+typedef struct profile_region {
+    /// @brief The name of the region, in flash.
+    const char *name;
+
+    /// @brief The next region in the list printed by profile_dump(), and whether the region is in
+    ///        it yet.
+    struct profile_region *next;
+    bool listed;
+
+    /// @brief The number of times the region ran.
+    uint32_t count;
+
+    /// @brief The shortest and longest runs, in cycles.
+    uint32_t min, max;
+
+    /// @brief The total length of every run, in cycles.
+    uint64_t total;
+} profile_region;
+
+#if BSP_PROFILE
+
+#include <avr/pgmspace.h>
+
+#include "bsp/clock.h"
+
+/// @brief Define a profiled region (at file scope).
+#define PROFILE_REGION_DEFINE(region)                                  \
+    static const char _profile_name_##region[] PROGMEM = #region;      \
+    static profile_region region = {.name = _profile_name_##region, .min = UINT32_MAX}
+
+/// @brief Start a run of a profiled region (in the same scope as the matching bsp_profile_end()).
+#define bsp_profile_begin(region) uint32_t _profile_start_##region = bsp_cycles()
+
+/// @brief End a run of a profiled region, recording its length.
+#define bsp_profile_end(region) profile_record(&(region), bsp_cycles() - _profile_start_##region)
+
+#else
+
+#define PROFILE_REGION_DEFINE(region) extern profile_region _profile_unused_##region
+#define bsp_profile_begin(region)     ((void)0)
+#define bsp_profile_end(region)       ((void)0)
+
+#endif
+
+/// @brief Record a run of a profiled region. Use bsp_profile_end() instead of calling this
+///        directly.
+/// @param region The region.
+/// @param cycles The length of the run, in cycles.
+void profile_record(profile_region *region, uint32_t cycles);
+
+/// @brief Print the statistics of every profiled region that has run over USART0, one line each:
+///        the name, the number of runs, and the minimum, average, maximum and total cycles.
+void profile_dump(void);
+
+/// @brief Reset the statistics of every profiled region that has run.
+void profile_reset(void);
+
+#endif  // _CALEBRJC_BSP_UTIL_PROFILE_H_
@@ -0,0 +1,14 @@
+#ifndef _CALEBRJC_BSP_SIM_AVR_INTERRUPT_H_
+#define _CALEBRJC_BSP_SIM_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+/// @brief Host stand-in for avr-libc's <avr/interrupt.h>. Interrupt handlers become ordinary
+///        functions that the simulator calls, and sei()/cli() only track the global interrupt flag.
+
+#define ISR(vector, ...) void vector(void)
+
+#define sei() (SREG |= _BV(7))
+#define cli() (SREG &= (uint8_t)~_BV(7))
+
+#endif  // _CALEBRJC_BSP_SIM_AVR_INTERRUPT_H_
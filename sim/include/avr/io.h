@@ -0,0 +1,260 @@
+#ifndef _CALEBRJC_BSP_SIM_AVR_IO_H_
+#define _CALEBRJC_BSP_SIM_AVR_IO_H_
+
+#include "bsp/sim.h"
+
+/// @brief Host stand-in for avr-libc's <avr/io.h>, backed by the simulated register file.
+
+#define _BV(bit) (1 << (bit))
+
+#define SREG sim_regs.sreg
+#define SMCR sim_regs.smcr
+
+// SREG bits
+#define SREG_I 7
+
+// SMCR bits
+#define SM2 3
+#define SM1 2
+#define SM0 1
+#define SE  0
+
+// IO ports
+#define PORTB sim_regs.portb
+#define PORTC sim_regs.portc
+#define PORTD sim_regs.portd
+#define DDRB  sim_regs.ddrb
+#define DDRC  sim_regs.ddrc
+#define DDRD  sim_regs.ddrd
+#define PINB  sim_regs.pinb
+#define PINC  sim_regs.pinc
+#define PIND  sim_regs.pind
+
+// External and pin change interrupts
+#define EICRA  sim_regs.eicra
+#define EIMSK  sim_regs.eimsk
+#define EIFR   sim_regs.eifr
+#define PCICR  sim_regs.pcicr
+#define PCIFR  sim_regs.pcifr
+#define PCMSK0 sim_regs.pcmsk0
+#define PCMSK1 sim_regs.pcmsk1
+#define PCMSK2 sim_regs.pcmsk2
+
+// EICRA bits
+#define ISC11 3
+#define ISC10 2
+#define ISC01 1
+#define ISC00 0
+
+// EIMSK and EIFR bits
+#define INT1  1
+#define INT0  0
+#define INTF1 1
+#define INTF0 0
+
+// PCICR and PCIFR bits
+#define PCIE2 2
+#define PCIE1 1
+#define PCIE0 0
+#define PCIF2 2
+#define PCIF1 1
+#define PCIF0 0
+
+// Timer0
+#define TCCR0A sim_regs.tccr0a
+#define TCCR0B sim_regs.tccr0b
+#define TCNT0  sim_regs.tcnt0
+#define OCR0A  sim_regs.ocr0a
+#define OCR0B  sim_regs.ocr0b
+#define TIMSK0 sim_regs.timsk0
+#define TIFR0  sim_regs.tifr0
+
+// TCCR0A bits
+#define COM0A1 7
+#define COM0A0 6
+#define COM0B1 5
+#define COM0B0 4
+#define WGM01  1
+#define WGM00  0
+
+// TCCR0B bits
+#define FOC0A 7
+#define FOC0B 6
+#define WGM02 3
+#define CS02  2
+#define CS01  1
+#define CS00  0
+
+// TIMSK0 and TIFR0 bits
+#define OCIE0B 2
+#define OCIE0A 1
+#define TOIE0  0
+#define OCF0B  2
+#define OCF0A  1
+#define TOV0   0
+
+// Timer1
+#define TCCR1A sim_regs.tccr1a
+#define TCCR1B sim_regs.tccr1b
+#define TCCR1C sim_regs.tccr1c
+#define TCNT1  sim_regs.tcnt1
+#define OCR1A  sim_regs.ocr1a
+#define OCR1B  sim_regs.ocr1b
+#define ICR1   sim_regs.icr1
+#define TIMSK1 sim_regs.timsk1
+#define TIFR1  sim_regs.tifr1
+
+// TCCR1A bits
+#define COM1A1 7
+#define COM1A0 6
+#define COM1B1 5
+#define COM1B0 4
+#define WGM11  1
+#define WGM10  0
+
+// TCCR1B bits
+#define ICNC1 7
+#define ICES1 6
+#define WGM13 4
+#define WGM12 3
+#define CS12  2
+#define CS11  1
+#define CS10  0
+
+// TIMSK1 and TIFR1 bits
+#define ICIE1  5
+#define OCIE1B 2
+#define OCIE1A 1
+#define TOIE1  0
+#define ICF1   5
+#define OCF1B  2
+#define OCF1A  1
+#define TOV1   0
+
+// Timer2
+#define TCCR2A sim_regs.tccr2a
+#define TCCR2B sim_regs.tccr2b
+#define TCNT2  sim_regs.tcnt2
+#define OCR2A  sim_regs.ocr2a
+#define OCR2B  sim_regs.ocr2b
+#define TIMSK2 sim_regs.timsk2
+#define TIFR2  sim_regs.tifr2
+
+// TCCR2A bits
+#define COM2A1 7
+#define COM2A0 6
+#define COM2B1 5
+#define COM2B0 4
+#define WGM21  1
+#define WGM20  0
+
+// TCCR2B bits
+#define FOC2A 7
+#define FOC2B 6
+#define WGM22 3
+#define CS22  2
+#define CS21  1
+#define CS20  0
+
+// TIMSK2 and TIFR2 bits
+#define OCIE2B 2
+#define OCIE2A 1
+#define TOIE2  0
+#define OCF2B  2
+#define OCF2A  1
+#define TOV2   0
+
+// USART0
+#define UDR0   sim_regs.udr0
+#define UCSR0A sim_regs.ucsr0a
+#define UCSR0B sim_regs.ucsr0b
+#define UCSR0C sim_regs.ucsr0c
+#define UBRR0H sim_regs.ubrr0h
+#define UBRR0L sim_regs.ubrr0l
+
+// UCSR0A bits
+#define RXC0  7
+#define TXC0  6
+#define UDRE0 5
+#define FE0   4
+#define DOR0  3
+#define UPE0  2
+#define U2X0  1
+#define MPCM0 0
+
+// UCSR0B bits
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ02 2
+#define RXB80  1
+#define TXB80  0
+
+// UCSR0C bits
+#define UMSEL01 7
+#define UMSEL00 6
+#define UPM01   5
+#define UPM00   4
+#define USBS0   3
+#define UCSZ01  2
+#define UCSZ00  1
+#define UCPOL0  0
+
+// SPI
+#define SPCR sim_regs.spcr
+#define SPSR sim_regs.spsr
+#define SPDR sim_regs.spdr
+
+// SPCR bits
+#define SPIE 7
+#define SPE  6
+#define DORD 5
+#define MSTR 4
+#define CPOL 3
+#define CPHA 2
+#define SPR1 1
+#define SPR0 0
+
+// SPSR bits
+#define SPIF  7
+#define WCOL  6
+#define SPI2X 0
+
+// TWI
+#define TWBR  sim_regs.twbr
+#define TWSR  sim_regs.twsr
+#define TWAR  sim_regs.twar
+#define TWDR  sim_regs.twdr
+#define TWCR  sim_regs.twcr
+#define TWAMR sim_regs.twamr
+
+// TWCR bits
+#define TWINT 7
+#define TWEA  6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC  3
+#define TWEN  2
+#define TWIE  0
+
+// TWSR bits
+#define TWPS1 1
+#define TWPS0 0
+
+// Interrupt vectors
+#define USART_RX_vect     sim_isr_usart_rx
+#define USART_UDRE_vect   sim_isr_usart_udre
+#define INT0_vect         sim_isr_int0
+#define INT1_vect         sim_isr_int1
+#define PCINT0_vect       sim_isr_pcint0
+#define PCINT1_vect       sim_isr_pcint1
+#define PCINT2_vect       sim_isr_pcint2
+#define TIMER0_OVF_vect   sim_isr_timer0_ovf
+#define TIMER1_OVF_vect   sim_isr_timer1_ovf
+#define TIMER2_COMPA_vect sim_isr_timer2_compa
+#define SPI_STC_vect      sim_isr_spi_stc
+#define TWI_vect          sim_isr_twi
+
+#endif  // _CALEBRJC_BSP_SIM_AVR_IO_H_
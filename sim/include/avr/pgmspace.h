@@ -0,0 +1,30 @@
+#ifndef _CALEBRJC_BSP_SIM_AVR_PGMSPACE_H_
+#define _CALEBRJC_BSP_SIM_AVR_PGMSPACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Host stand-in for avr-libc's <avr/pgmspace.h>. The host has a single address space, so
+///        "program memory" is ordinary memory.
+
+#define PROGMEM
+
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+
+static inline size_t strlcpy_P(char *dst, const char *src, size_t size) {
+    size_t length = 0;
+
+    while (src[length]) length++;
+
+    if (size > 0) {
+        size_t count = (length < size) ? length : size - 1;
+        for (size_t i = 0; i < count; i++) dst[i] = src[i];
+        dst[count] = '\0';
+    }
+
+    return length;
+}
+
+#endif  // _CALEBRJC_BSP_SIM_AVR_PGMSPACE_H_
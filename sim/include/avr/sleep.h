@@ -0,0 +1,22 @@
+#ifndef _CALEBRJC_BSP_SIM_AVR_SLEEP_H_
+#define _CALEBRJC_BSP_SIM_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+/// @brief Host stand-in for avr-libc's <avr/sleep.h>. The sleep instruction runs the simulator's
+///        sleep hook (see sim_set_sleep_hook()).
+
+#define SLEEP_MODE_IDLE        0
+#define SLEEP_MODE_ADC         _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN    _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE    (_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY     (_BV(SM1) | _BV(SM2))
+#define SLEEP_MODE_EXT_STANDBY (_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode) (SMCR = (uint8_t)((SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode)))
+
+#define sleep_enable()  (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= (uint8_t)~_BV(SE))
+#define sleep_cpu()     sim_sleep()
+
+#endif  // _CALEBRJC_BSP_SIM_AVR_SLEEP_H_
@@ -0,0 +1,192 @@
+#ifndef _CALEBRJC_BSP_SIM_H_
+#define _CALEBRJC_BSP_SIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Host-side simulation of the ATmega328P peripherals used by the BSP.
+
+// Note:
+// This header (and the avr/ and util/ headers next to it) is only on the include path in native
+// (non-cross) builds. The BSP sources include <avr/io.h> and <avr/interrupt.h> exactly as they do
+// on the target, and those headers resolve to the shims in this directory, which map every
+// register onto a field of sim_regs. Interrupt service routines are compiled as ordinary functions
+// and are invoked by the sim_* functions below, which play the role of the hardware.
+
+/// @brief Value held by the simulated UDR0 when no byte has been written to it. UDR0 is modelled
+///        wider than the real 8-bit register so that the simulator can tell whether an ISR wrote
+///        it; no uint8_t or char value converts to this.
+#define SIM_UDR0_EMPTY INT16_MIN
+
+/// @brief Set in the simulated UDR0 alongside a received byte while the receive complete handler
+///        runs. Reading UDR0 into a uint8_t or char drops it, while any byte the handler writes to
+///        UDR0 (to transmit it) clears it.
+#define SIM_UDR0_RX_TAG 0x4000
+
+/// @brief Set in the simulated SPDR alongside the byte last received, until a byte is written to
+///        it to start the next exchange. Reading SPDR into a uint8_t drops it.
+#define SIM_SPDR_RX_TAG 0x4000
+
+/// @brief Set in the simulated TWCR whenever the simulator updates it, until the TWI's next bus
+///        action is requested by writing it. Reading TWCR into a uint8_t drops it.
+#define SIM_TWCR_TAG 0x4000
+
+/// @brief The simulated register file.
+typedef struct {
+    /// @brief The status register (only the global interrupt flag is modelled).
+    volatile uint8_t sreg;
+
+    /// @brief The sleep mode control register.
+    volatile uint8_t smcr;
+
+    /// @brief The IO port registers.
+    volatile uint8_t portb, portc, portd;
+    volatile uint8_t ddrb, ddrc, ddrd;
+    volatile uint8_t pinb, pinc, pind;
+
+    /// @brief The external and pin change interrupt registers.
+    volatile uint8_t eicra, eimsk, eifr;
+    volatile uint8_t pcicr, pcifr;
+    volatile uint8_t pcmsk0, pcmsk1, pcmsk2;
+
+    /// @brief The Timer0 registers.
+    volatile uint8_t tccr0a, tccr0b, tcnt0, ocr0a, ocr0b;
+    volatile uint8_t timsk0, tifr0;
+
+    /// @brief The Timer1 registers.
+    volatile uint8_t tccr1a, tccr1b, tccr1c;
+    volatile uint16_t tcnt1, ocr1a, ocr1b, icr1;
+    volatile uint8_t timsk1, tifr1;
+
+    /// @brief The Timer2 registers.
+    volatile uint8_t tccr2a, tccr2b, tcnt2, ocr2a, ocr2b;
+    volatile uint8_t timsk2, tifr2;
+
+    /// @brief The USART0 registers.
+    volatile int16_t udr0;
+    volatile uint8_t ucsr0a, ucsr0b, ucsr0c;
+    volatile uint8_t ubrr0h, ubrr0l;
+
+    /// @brief The SPI registers.
+    volatile uint8_t spcr, spsr;
+    volatile int16_t spdr;
+
+    /// @brief The TWI registers.
+    volatile uint8_t twbr, twsr, twar, twdr, twamr;
+    volatile int16_t twcr;
+} sim_register_file;
+
+/// @brief The simulated register file.
+extern sim_register_file sim_regs;
+
+/// @brief Reset every simulated register to its power-on value.
+void sim_reset(void);
+
+/// @brief A function called when the CPU goes to sleep (see sim_set_sleep_hook()).
+typedef void (*sim_sleep_hook)(void);
+
+/// @brief Set a function to run whenever the BSP puts the CPU to sleep, standing in for the
+///        interrupt that would wake it (e.g. by calling sim_usart0_receive()). Without one, sleeping
+///        returns immediately, as if woken by an unrelated interrupt.
+/// @param hook The sleep hook, or NULL for none.
+void sim_set_sleep_hook(sim_sleep_hook hook);
+
+/// @brief Put the simulated CPU to sleep (the sleep instruction). Called by sleep_cpu().
+void sim_sleep(void);
+
+/// @brief Simulate the reception of a byte on USART0, running the receive complete interrupt
+///        handler if the receiver and its interrupt are enabled.
+/// @param byte The byte received on the line.
+/// @return True if the receive complete interrupt handler was run.
+bool sim_usart0_receive(uint8_t byte);
+
+/// @brief Like sim_usart0_receive(), but with receive error flags (any of _BV(FE0), _BV(DOR0) and
+///        _BV(UPE0)) set in UCSR0A while the handler runs.
+/// @param byte The byte received on the line.
+/// @param error_flags The UCSR0A error flags to report for the byte.
+/// @return True if the receive complete interrupt handler was run.
+bool sim_usart0_receive_with_errors(uint8_t byte, uint8_t error_flags);
+
+/// @brief Simulate the USART0 transmitter becoming ready: send the byte written to UDR0 by the
+///        receive complete handler, if any, or else run the data register empty interrupt handler
+///        if its interrupt is enabled.
+/// @param o_byte The byte sent, if any.
+/// @return True if a byte was sent.
+bool sim_usart0_transmit(uint8_t *o_byte);
+
+/// @brief Run the data register empty interrupt handler until it stops sending data.
+/// @param o_buf The buffer to store transmitted bytes in, or NULL to discard them.
+/// @param capacity The capacity of o_buf. Bytes beyond it are transmitted but discarded.
+/// @return The number of bytes transmitted.
+size_t sim_usart0_drain(uint8_t *o_buf, size_t capacity);
+
+/// @brief Simulate the exchange of a byte on the SPI: if a byte has been written to SPDR, send it,
+///        receive miso into SPDR and run the serial transfer complete interrupt handler if its
+///        interrupt is enabled.
+/// @param miso The byte sent by the device.
+/// @param o_mosi The byte sent by the SPI, if any.
+/// @return True if a byte was exchanged.
+bool sim_spi_exchange(uint8_t miso, uint8_t *o_mosi);
+
+/// @brief Exchange bytes on the SPI until it stops sending.
+/// @param miso The bytes sent by the device, or NULL to send 0xFF. Beyond capacity, the device
+///        sends 0xFF.
+/// @param o_mosi The buffer to store the bytes sent by the SPI in, or NULL to discard them.
+/// @param capacity The capacity of miso and o_mosi. Bytes beyond it are exchanged but discarded.
+/// @return The number of bytes exchanged.
+size_t sim_spi_run(const uint8_t *miso, uint8_t *o_mosi, size_t capacity);
+
+/// @brief Attach a simulated device to the TWI bus, replacing any attached device. The device
+///        behaves like a typical register-based peripheral (e.g. an EEPROM or a sensor): the first
+///        byte written after its address sets its register pointer, further bytes are written to
+///        memory from the pointer, and reads return memory from the pointer, which advances with
+///        every byte. It does not acknowledge bytes written past the end of its memory, and reads
+///        past the end return 0xFF.
+/// @param address The 7-bit address of the device.
+/// @param memory The device's registers, or NULL to detach the device.
+/// @param size The number of registers.
+void sim_twi_attach(uint8_t address, uint8_t *memory, size_t size);
+
+/// @brief Simulate the TWI carrying out the bus action requested through TWCR, if any, with the
+///        attached device: set TWSR to the resulting status and run the TWI interrupt handler if
+///        its interrupt is enabled. A STOP condition on its own completes without an interrupt.
+/// @return True if a bus action was carried out.
+bool sim_twi_step(void);
+
+/// @brief Carry out bus actions on the TWI until it stops requesting them.
+/// @return The number of bus actions carried out.
+size_t sim_twi_run(void);
+
+/// @brief Simulate the input levels of an IO port changing, running the external interrupt (for
+///        PD2 and PD3) and pin change interrupt handlers that the change triggers.
+/// @param port The index of the port (0 for port B, 1 for port C and 2 for port D).
+/// @param levels The new input levels of the port's pins (bit n for pin n).
+/// @return True if any interrupt handler was run.
+bool sim_port_input(uint8_t port, uint8_t levels);
+
+/// @brief Simulate the passing of CPU cycles: advance Timer0 and Timer1 (in normal mode) and
+///        Timer2 (in CTC mode) according to their prescalers, running their overflow and compare
+///        match A interrupt handlers as the hardware would.
+/// @param cycles The number of CPU cycles.
+void sim_advance_cycles(uint32_t cycles);
+
+/// @brief Simulate a Timer2 compare match A, running its interrupt handler if it is enabled.
+/// @return True if the interrupt handler was run.
+bool sim_timer2_compare_a(void);
+
+// Interrupt service routines, as defined by the BSP sources through ISR().
+void sim_isr_usart_rx(void);
+void sim_isr_usart_udre(void);
+void sim_isr_int0(void);
+void sim_isr_int1(void);
+void sim_isr_pcint0(void);
+void sim_isr_pcint1(void);
+void sim_isr_pcint2(void);
+void sim_isr_timer0_ovf(void);
+void sim_isr_timer1_ovf(void);
+void sim_isr_timer2_compa(void);
+void sim_isr_spi_stc(void);
+void sim_isr_twi(void);
+
+#endif  // _CALEBRJC_BSP_SIM_H_
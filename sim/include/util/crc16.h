@@ -0,0 +1,19 @@
+#ifndef _CALEBRJC_BSP_SIM_UTIL_CRC16_H_
+#define _CALEBRJC_BSP_SIM_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+/// @brief Host stand-in for avr-libc's <util/crc16.h>, with the same results as its optimized
+///        inline assembly.
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+#endif  // _CALEBRJC_BSP_SIM_UTIL_CRC16_H_
@@ -0,0 +1,15 @@
+#ifndef _CALEBRJC_BSP_SIM_UTIL_DELAY_H_
+#define _CALEBRJC_BSP_SIM_UTIL_DELAY_H_
+
+/// @brief Host stand-in for avr-libc's <util/delay.h>. Simulated time does not advance, so delays
+///        return immediately.
+
+static inline void _delay_ms(double ms) {
+    (void)ms;
+}
+
+static inline void _delay_us(double us) {
+    (void)us;
+}
+
+#endif  // _CALEBRJC_BSP_SIM_UTIL_DELAY_H_
@@ -0,0 +1,382 @@
+#include "bsp/sim.h"
+
+#include <avr/io.h>
+#include <util/twi.h>
+
+sim_register_file sim_regs;
+
+// A byte written to UDR0 by the receive complete handler, waiting to be transmitted (or -1)
+static int16_t sim_usart0_tx_direct = -1;
+
+// The device attached to the TWI bus (see sim_twi_attach())
+static struct {
+    uint8_t address;
+    uint8_t *memory;
+    size_t size;
+    size_t pointer;
+} sim_twi_device;
+
+// The state of the TWI bus: whether it is held (between a START and a STOP), whether the next byte
+// is an address, whether the device was addressed (for a read), and whether it has received its
+// register pointer since it was addressed
+static struct sim_twi_bus_state {
+    bool held;
+    bool expect_address;
+    bool selected;
+    bool reading;
+    bool pointer_set;
+} sim_twi_bus;
+
+// The function run when the CPU goes to sleep (initialized in sim_set_sleep_hook())
+static sim_sleep_hook sim_current_sleep_hook = NULL;
+
+// The cycles counted towards each timer's next tick (see sim_advance_cycles())
+static uint32_t sim_timer_residual[3];
+
+void sim_reset(void) {
+    sim_timer_residual[0] = sim_timer_residual[1] = sim_timer_residual[2] = 0;
+    sim_usart0_tx_direct  = -1;
+    sim_twi_bus           = (struct sim_twi_bus_state){0};
+
+    sim_regs = (sim_register_file){
+        .udr0   = SIM_UDR0_EMPTY,
+        .ucsr0a = _BV(UDRE0),
+        .ucsr0c = _BV(UCSZ01) | _BV(UCSZ00),
+        .spdr   = SIM_SPDR_RX_TAG,
+        .twbr   = 0,
+        .twsr   = TW_NO_INFO,
+        .twcr   = SIM_TWCR_TAG,
+    };
+}
+
+void sim_set_sleep_hook(sim_sleep_hook hook) {
+    sim_current_sleep_hook = hook;
+}
+
+void sim_sleep(void) {
+    // The sleep instruction does nothing unless sleeping is enabled
+    if (!(SMCR & _BV(SE))) return;
+
+    if (sim_current_sleep_hook) sim_current_sleep_hook();
+}
+
+bool sim_usart0_receive(uint8_t byte) {
+    return sim_usart0_receive_with_errors(byte, 0);
+}
+
+bool sim_usart0_receive_with_errors(uint8_t byte, uint8_t error_flags) {
+    // Without the receiver, the byte never makes it into UDR0
+    if (!(UCSR0B & _BV(RXEN0))) return false;
+
+    UDR0 = byte;
+    UCSR0A |= _BV(RXC0) | (error_flags & (_BV(FE0) | _BV(DOR0) | _BV(UPE0)));
+
+    if (!(UCSR0B & _BV(RXCIE0))) return false;
+
+    // Tag the received byte, so that a byte written to UDR0 by the handler (the separate transmit
+    // buffer on hardware) can be told apart from it afterwards
+    UDR0 = byte | SIM_UDR0_RX_TAG;
+    sim_isr_usart_rx();
+
+    if (UDR0 != (byte | SIM_UDR0_RX_TAG)) {
+        // The transmitter takes the byte, and is busy until it has been transmitted
+        sim_usart0_tx_direct = (uint8_t)UDR0;
+        UCSR0A &= (uint8_t)~_BV(UDRE0);
+    }
+    UDR0 = SIM_UDR0_EMPTY;
+
+    // Reading UDR0 clears the flags on hardware; model it unconditionally
+    UCSR0A &= ~(_BV(RXC0) | _BV(FE0) | _BV(DOR0) | _BV(UPE0));
+
+    return true;
+}
+
+bool sim_usart0_transmit(uint8_t *o_byte) {
+    // A byte written to UDR0 outside of the data register empty handler goes out first
+    if (sim_usart0_tx_direct >= 0) {
+        if (o_byte) *o_byte = (uint8_t)sim_usart0_tx_direct;
+        sim_usart0_tx_direct = -1;
+        UCSR0A |= _BV(UDRE0);
+
+        return true;
+    }
+
+    if (!(UCSR0B & _BV(UDRIE0))) return false;
+
+    UDR0 = SIM_UDR0_EMPTY;
+    sim_isr_usart_udre();
+
+    if (UDR0 == SIM_UDR0_EMPTY) return false;
+
+    if (o_byte) *o_byte = (uint8_t)UDR0;
+    UDR0 = SIM_UDR0_EMPTY;
+
+    return true;
+}
+
+size_t sim_usart0_drain(uint8_t *o_buf, size_t capacity) {
+    size_t count = 0;
+    uint8_t byte;
+
+    while (sim_usart0_transmit(&byte)) {
+        if (o_buf && count < capacity) o_buf[count] = byte;
+        count++;
+    }
+
+    return count;
+}
+
+/// @brief Return whether an external interrupt's sense control (ISCn1:ISCn0) triggers on a change
+///        of its pin to the given level.
+static bool sim_external_interrupt_sensed(uint8_t interrupt, bool level) {
+    switch ((EICRA >> (interrupt * 2)) & 0x03) {
+        case 0x00:  // Low level
+        case 0x02:  // Falling edge
+            return !level;
+        case 0x01:  // Any change
+            return true;
+        default:  // Rising edge
+            return level;
+    }
+}
+
+bool sim_spi_exchange(uint8_t miso, uint8_t *o_mosi) {
+    // A tagged SPDR has not been written since the last exchange
+    if (!(SPCR & _BV(SPE)) || (SPDR & SIM_SPDR_RX_TAG)) return false;
+
+    if (o_mosi) *o_mosi = (uint8_t)SPDR;
+
+    SPDR = miso | SIM_SPDR_RX_TAG;
+    SPSR |= _BV(SPIF);
+
+    if (SPCR & _BV(SPIE)) {
+        sim_isr_spi_stc();
+
+        // Running the handler clears the flag on hardware
+        SPSR &= (uint8_t)~_BV(SPIF);
+    }
+
+    return true;
+}
+
+size_t sim_spi_run(const uint8_t *miso, uint8_t *o_mosi, size_t capacity) {
+    size_t count = 0;
+    uint8_t mosi;
+
+    while (sim_spi_exchange((miso && count < capacity) ? miso[count] : 0xFF, &mosi)) {
+        if (o_mosi && count < capacity) o_mosi[count] = mosi;
+        count++;
+    }
+
+    return count;
+}
+
+void sim_twi_attach(uint8_t address, uint8_t *memory, size_t size) {
+    sim_twi_device.address = address;
+    sim_twi_device.memory  = memory;
+    sim_twi_device.size    = memory ? size : 0;
+    sim_twi_device.pointer = 0;
+}
+
+/// @brief Return the status of an address byte sent on the TWI bus, selecting the attached device
+///        if it matches.
+static uint8_t sim_twi_address(uint8_t byte) {
+    sim_twi_bus.reading     = byte & TW_READ;
+    sim_twi_bus.selected    = sim_twi_device.memory && (byte >> 1) == sim_twi_device.address;
+    sim_twi_bus.pointer_set = false;
+
+    if (sim_twi_bus.reading) return sim_twi_bus.selected ? TW_MR_SLA_ACK : TW_MR_SLA_NACK;
+    return sim_twi_bus.selected ? TW_MT_SLA_ACK : TW_MT_SLA_NACK;
+}
+
+/// @brief Return the status of a data byte written to the attached device.
+static uint8_t sim_twi_write(uint8_t byte) {
+    if (!sim_twi_bus.pointer_set) {
+        sim_twi_device.pointer  = byte;
+        sim_twi_bus.pointer_set = true;
+
+        return TW_MT_DATA_ACK;
+    }
+
+    if (sim_twi_device.pointer >= sim_twi_device.size) return TW_MT_DATA_NACK;
+
+    sim_twi_device.memory[sim_twi_device.pointer++] = byte;
+
+    return TW_MT_DATA_ACK;
+}
+
+bool sim_twi_step(void) {
+    // A tagged TWCR has not been written since the simulator last updated it
+    int16_t twcr = TWCR;
+    if ((twcr & SIM_TWCR_TAG) || !(twcr & _BV(TWEN)) || !(twcr & _BV(TWINT))) return false;
+
+    // The TWI clears TWSTO (but not TWSTA) once it has sent a STOP condition
+    uint8_t control = (uint8_t)twcr & (uint8_t)~_BV(TWSTO);
+    uint8_t status;
+
+    if (twcr & _BV(TWSTO)) {
+        sim_twi_bus.held = false;
+
+        // A STOP on its own leaves TWINT cleared, and does not request the interrupt
+        if (!(control & _BV(TWSTA))) {
+            TWCR = (control & (uint8_t)~_BV(TWINT)) | SIM_TWCR_TAG;
+            return true;
+        }
+    }
+
+    if (control & _BV(TWSTA)) {
+        status                     = sim_twi_bus.held ? TW_REP_START : TW_START;
+        sim_twi_bus.held           = true;
+        sim_twi_bus.expect_address = true;
+    } else if (!sim_twi_bus.held) {
+        status = TW_BUS_ERROR;
+    } else if (sim_twi_bus.expect_address) {
+        status                     = sim_twi_address((uint8_t)TWDR);
+        sim_twi_bus.expect_address = false;
+    } else if (!sim_twi_bus.reading) {
+        status = sim_twi_bus.selected ? sim_twi_write((uint8_t)TWDR) : TW_MT_DATA_NACK;
+    } else {
+        size_t pointer = sim_twi_device.pointer++;
+
+        TWDR   = (pointer < sim_twi_device.size) ? sim_twi_device.memory[pointer] : 0xFF;
+        status = (control & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+    }
+
+    TWSR = (TWSR & (_BV(TWPS1) | _BV(TWPS0))) | status;
+    TWCR = control | _BV(TWINT) | SIM_TWCR_TAG;
+
+    if (control & _BV(TWIE)) sim_isr_twi();
+
+    return true;
+}
+
+size_t sim_twi_run(void) {
+    size_t count = 0;
+
+    while (sim_twi_step()) {
+        count++;
+    }
+
+    return count;
+}
+
+bool sim_port_input(uint8_t port, uint8_t levels) {
+    static volatile uint8_t *const pin_registers[]   = {&PINB, &PINC, &PIND};
+    static volatile uint8_t *const pcmsk_registers[] = {&PCMSK0, &PCMSK1, &PCMSK2};
+    static void (*const pcint_handlers[])(void) = {sim_isr_pcint0, sim_isr_pcint1, sim_isr_pcint2};
+
+    uint8_t changed      = *pin_registers[port] ^ levels;
+    *pin_registers[port] = levels;
+
+    bool handled = false;
+
+    // INT0 and INT1 are on PD2 and PD3
+    if (port == 2) {
+        for (uint8_t interrupt = 0; interrupt < 2; interrupt++) {
+            uint8_t mask = (uint8_t)_BV(2 + interrupt);
+            bool level   = levels & mask;
+
+            if (!(changed & mask) || !sim_external_interrupt_sensed(interrupt, level)) continue;
+            if (!(EIMSK & _BV(interrupt))) continue;
+
+            (interrupt == 0) ? sim_isr_int0() : sim_isr_int1();
+            handled = true;
+        }
+    }
+
+    if ((changed & *pcmsk_registers[port]) && (PCICR & _BV(port))) {
+        pcint_handlers[port]();
+        handled = true;
+    }
+
+    return handled;
+}
+
+bool sim_timer2_compare_a(void) {
+    TIFR2 |= _BV(OCF2A);
+
+    if (!(TIMSK2 & _BV(OCIE2A))) return false;
+
+    // Running the handler clears the flag on hardware
+    sim_isr_timer2_compa();
+    TIFR2 &= (uint8_t)~_BV(OCF2A);
+
+    return true;
+}
+
+/// @brief Return the prescaler selected by a timer's clock select bits (CSn2:CSn0), or 0 if it is
+///        stopped (or clocked externally, which is not simulated).
+static uint16_t sim_timer_prescaler(uint8_t clock_select, bool timer2) {
+    static const uint16_t prescalers[]        = {0, 1, 8, 64, 256, 1024, 0, 0};
+    static const uint16_t timer2_prescalers[] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+    return (timer2 ? timer2_prescalers : prescalers)[clock_select & 0x07];
+}
+
+/// @brief Return the number of prescaled ticks that a timer advances by in the given cycles.
+static uint32_t sim_timer_ticks(uint8_t timer, uint8_t clock_select, uint32_t cycles) {
+    uint16_t prescaler = sim_timer_prescaler(clock_select, timer == 2);
+    if (!prescaler) return 0;
+
+    uint64_t total            = (uint64_t)sim_timer_residual[timer] + cycles;
+    sim_timer_residual[timer] = (uint32_t)(total % prescaler);
+
+    return (uint32_t)(total / prescaler);
+}
+
+void sim_advance_cycles(uint32_t cycles) {
+    // Timer0 (normal mode)
+    for (uint32_t ticks = sim_timer_ticks(0, TCCR0B, cycles); ticks > 0;) {
+        uint32_t to_overflow = 256U - TCNT0;
+
+        if (ticks < to_overflow) {
+            TCNT0 = (uint8_t)(TCNT0 + ticks);
+            break;
+        }
+
+        ticks -= to_overflow;
+        TCNT0 = 0;
+        TIFR0 |= _BV(TOV0);
+
+        if (TIMSK0 & _BV(TOIE0)) {
+            sim_isr_timer0_ovf();
+            TIFR0 &= (uint8_t)~_BV(TOV0);
+        }
+    }
+
+    // Timer1 (normal mode)
+    for (uint32_t ticks = sim_timer_ticks(1, TCCR1B, cycles); ticks > 0;) {
+        uint32_t to_overflow = 65536U - TCNT1;
+
+        if (ticks < to_overflow) {
+            TCNT1 = (uint16_t)(TCNT1 + ticks);
+            break;
+        }
+
+        ticks -= to_overflow;
+        TCNT1 = 0;
+        TIFR1 |= _BV(TOV1);
+
+        if (TIMSK1 & _BV(TOIE1)) {
+            sim_isr_timer1_ovf();
+            TIFR1 &= (uint8_t)~_BV(TOV1);
+        }
+    }
+
+    // Timer2 (CTC mode, in which compare match A clears the counter)
+    if (!(TCCR2A & _BV(WGM21))) return;
+
+    for (uint32_t ticks = sim_timer_ticks(2, TCCR2B, cycles); ticks > 0;) {
+        uint32_t to_match = (TCNT2 <= OCR2A) ? (uint32_t)(OCR2A - TCNT2) + 1
+                                             : 256U - TCNT2 + OCR2A + 1;
+
+        if (ticks < to_match) {
+            TCNT2 = (uint8_t)(TCNT2 + ticks);
+            break;
+        }
+
+        ticks -= to_match;
+        TCNT2 = 0;
+        sim_timer2_compare_a();
+    }
+}
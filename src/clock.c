@@ -0,0 +1,126 @@
+#include "bsp/clock.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#ifndef F_CPU
+#error "F_CPU must be defined to use the clock."
+#endif
+
+// Timer0 runs from the system clock divided by this prescaler (CS02:CS00 = 011)
+#define CLOCK_TIMER0_PRESCALER 64UL
+
+#define CLOCK_CYCLES_PER_US (F_CPU / 1000000UL)
+
+#if CLOCK_CYCLES_PER_US == 0 || CLOCK_TIMER0_PRESCALER % CLOCK_CYCLES_PER_US != 0
+#error "The clock requires F_CPU to be 1, 2, 4, 8 or 16 MHz."
+#endif
+
+// The length of a Timer0 tick and overflow, in microseconds
+#define CLOCK_US_PER_TICK     (CLOCK_TIMER0_PRESCALER / CLOCK_CYCLES_PER_US)
+#define CLOCK_US_PER_OVERFLOW (CLOCK_US_PER_TICK * 256UL)
+
+// Timer0 state (written by its overflow interrupt): the number of overflows, and the time they
+// add up to, in whole milliseconds plus the microseconds left over
+static volatile uint32_t clock_timer0_overflows = 0;
+static volatile uint32_t clock_millis           = 0;
+static volatile uint16_t clock_millis_remainder = 0;
+
+// The high half of the cycle counter (written by the Timer1 overflow interrupt)
+static volatile uint16_t clock_timer1_overflows = 0;
+
+// Interrupt handlers ------------------------------------------------------------------------------
+
+/// @brief Timer0 overflow interrupt handler.
+ISR(TIMER0_OVF_vect) {
+    uint32_t millis    = clock_millis + CLOCK_US_PER_OVERFLOW / 1000;
+    uint16_t remainder = clock_millis_remainder + CLOCK_US_PER_OVERFLOW % 1000;
+
+    if (remainder >= 1000) {
+        remainder -= 1000;
+        millis++;
+    }
+
+    clock_millis           = millis;
+    clock_millis_remainder = remainder;
+    clock_timer0_overflows++;
+}
+
+/// @brief Timer1 overflow interrupt handler.
+ISR(TIMER1_OVF_vect) {
+    clock_timer1_overflows++;
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void clock_init(void) {
+    // Timer0: normal mode, counting the system clock / 64
+    TIMSK0 &= (uint8_t)~_BV(TOIE0);
+    TCCR0A = 0;
+    TCCR0B = _BV(CS01) | _BV(CS00);
+    TCNT0  = 0;
+
+    // Timer1: normal mode, counting every cycle
+    TIMSK1 &= (uint8_t)~_BV(TOIE1);
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1  = 0;
+
+    clock_timer0_overflows = 0;
+    clock_millis           = 0;
+    clock_millis_remainder = 0;
+    clock_timer1_overflows = 0;
+
+    // Clear any pending overflows (by writing a one to their flags), then enable the interrupts
+    TIFR0 = _BV(TOV0);
+    TIFR1 = _BV(TOV1);
+    TIMSK0 |= _BV(TOIE0);
+    TIMSK1 |= _BV(TOIE1);
+}
+
+// Note:
+// The counts are wider than a byte, so they are read with interrupts disabled. Masking only the
+// overflow interrupts would take a read-modify-write of TIMSK0/TIMSK1 on every call, and turn them
+// back on even when the application (or an interrupt handler calling in) had turned them off.
+
+uint32_t bsp_millis(void) {
+    uint8_t sreg = SREG;
+    cli();
+
+    uint32_t millis = clock_millis;
+
+    SREG = sreg;
+
+    return millis;
+}
+
+uint32_t bsp_micros(void) {
+    uint8_t sreg = SREG;
+    cli();
+
+    uint32_t overflows = clock_timer0_overflows;
+    uint8_t ticks      = TCNT0;
+
+    // The timer may have overflowed since interrupts were disabled; if so, and the count was read
+    // after the overflow, count it here
+    if ((TIFR0 & _BV(TOV0)) && ticks < 255) overflows++;
+
+    SREG = sreg;
+
+    return ((overflows << 8) + ticks) * CLOCK_US_PER_TICK;
+}
+
+uint32_t bsp_cycles(void) {
+    uint8_t sreg = SREG;
+    cli();
+
+    uint16_t overflows = clock_timer1_overflows;
+    uint16_t cycles    = TCNT1;
+
+    // As in bsp_micros(), count an overflow that is still pending
+    if ((TIFR1 & _BV(TOV1)) && cycles < 0xFFFF) overflows++;
+
+    SREG = sreg;
+
+    return ((uint32_t)overflows << 16) | cycles;
+}
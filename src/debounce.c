@@ -0,0 +1,154 @@
+#define BSP_ASSERT_FILE_ID BSP_ASSERT_FILE_ID_DEBOUNCE
+
+#include "bsp/debounce.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "bsp/sched.h"
+#include "bsp/util/assert.h"
+
+#ifndef F_CPU
+#error "F_CPU must be defined to use the debounce service."
+#endif
+
+// Timer2 runs from the system clock divided by this prescaler (CS22:CS20 = 111)
+#define DEBOUNCE_TIMER_PRESCALER 1024UL
+
+// The number of IO ports (B, C and D)
+#define DEBOUNCE_PORT_COUNT 3
+
+/// @brief The debounce state of an IO port, one bit per pin.
+typedef struct {
+    /// @brief The pins being debounced.
+    uint8_t mask;
+
+    /// @brief The debounced levels.
+    uint8_t state;
+
+    /// @brief The low and high bits of each pin's vertical counter, which counts the consecutive
+    ///        samples that differ from the debounced level (reset to 11, and rolls over to 11).
+    uint8_t ct0, ct1;
+
+    /// @brief The latched edges of the debounced levels.
+    uint8_t rising, falling;
+} debounce_port;
+
+// Shared between the Timer2 interrupt and the main loop; the main loop only writes them with the
+// interrupt masked
+static volatile debounce_port debounce_ports[DEBOUNCE_PORT_COUNT] = {0};
+
+// Interrupt handlers ------------------------------------------------------------------------------
+
+/// @brief Run one step of a port's vertical counter on a sample of its levels.
+static inline void debounce_sample(volatile debounce_port *port, uint8_t levels) {
+    uint8_t state = port->state;
+
+    // Count the pins that read differently from their debounced level, and reset the others
+    uint8_t delta = (levels ^ state) & port->mask;
+    uint8_t ct0   = (uint8_t)~(port->ct0 & delta);
+    uint8_t ct1   = ct0 ^ (port->ct1 & delta);
+
+    port->ct0 = ct0;
+    port->ct1 = ct1;
+
+    // Flip the pins whose counters rolled over
+    uint8_t toggled = delta & ct0 & ct1;
+    if (!toggled) return;
+
+    state ^= toggled;
+
+    port->state = state;
+    port->rising |= state & toggled;
+    port->falling |= (uint8_t)~state & toggled;
+
+    sched_post_from_isr(SCHED_EVENT_DEBOUNCE);
+}
+
+/// @brief Timer2 compare match A interrupt handler. Samples every port.
+ISR(TIMER2_COMPA_vect) {
+    debounce_sample(&debounce_ports[IO_PORT_B], io_read_port(IO_PORT_B));
+    debounce_sample(&debounce_ports[IO_PORT_C], io_read_port(IO_PORT_C));
+    debounce_sample(&debounce_ports[IO_PORT_D], io_read_port(IO_PORT_D));
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void debounce_init(uint8_t period_ms) {
+    uint32_t counts = ((uint32_t)F_CPU / 1000UL * period_ms + DEBOUNCE_TIMER_PRESCALER / 2) /
+                      DEBOUNCE_TIMER_PRESCALER;
+
+    bsp_assert(counts >= 1 && counts <= 256, "Debounce period of %u ms is not supported.", period_ms);
+
+    // Clear the timer on compare match (CTC mode), counting from the prescaled clock
+    TIMSK2 &= (uint8_t)~_BV(OCIE2A);
+    TCCR2A = _BV(WGM21);
+    TCCR2B = _BV(CS22) | _BV(CS21) | _BV(CS20);
+    OCR2A  = (uint8_t)(counts - 1);
+    TCNT2  = 0;
+
+    // Clear any pending compare match (by writing a one to its flag), then enable the interrupt
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 |= _BV(OCIE2A);
+}
+
+void debounce_add_mask(io_port port, uint8_t mask) {
+    volatile debounce_port *state = &debounce_ports[port];
+
+    // Mask the Timer2 interrupt, the only other writer of the port's state, while updating it
+    uint8_t timsk2 = TIMSK2;
+    TIMSK2         = timsk2 & (uint8_t)~_BV(OCIE2A);
+
+    state->mask |= mask;
+    state->state = (uint8_t)((state->state & ~mask) | (io_read_port(port) & mask));
+    state->ct0 |= mask;
+    state->ct1 |= mask;
+    state->rising &= (uint8_t)~mask;
+    state->falling &= (uint8_t)~mask;
+
+    TIMSK2 = timsk2;
+}
+
+void debounce_add(io_pin pin) {
+    debounce_add_mask(IO_PIN_PORT(pin), IO_PIN_MASK(pin));
+}
+
+uint8_t debounce_read_port(io_port port) {
+    return debounce_ports[port].state & debounce_ports[port].mask;
+}
+
+io_logic_level debounce_read(io_pin pin) {
+    return (debounce_read_port(IO_PIN_PORT(pin)) & IO_PIN_MASK(pin)) ? IO_HIGH : IO_LOW;
+}
+
+uint8_t debounce_take_rising(io_port port, uint8_t mask) {
+    uint8_t timsk2 = TIMSK2;
+    TIMSK2         = timsk2 & (uint8_t)~_BV(OCIE2A);
+
+    uint8_t edges = debounce_ports[port].rising & mask;
+    debounce_ports[port].rising &= (uint8_t)~edges;
+
+    TIMSK2 = timsk2;
+
+    return edges;
+}
+
+uint8_t debounce_take_falling(io_port port, uint8_t mask) {
+    uint8_t timsk2 = TIMSK2;
+    TIMSK2         = timsk2 & (uint8_t)~_BV(OCIE2A);
+
+    uint8_t edges = debounce_ports[port].falling & mask;
+    debounce_ports[port].falling &= (uint8_t)~edges;
+
+    TIMSK2 = timsk2;
+
+    return edges;
+}
+
+bool debounce_rose(io_pin pin) {
+    return debounce_take_rising(IO_PIN_PORT(pin), IO_PIN_MASK(pin)) != 0;
+}
+
+bool debounce_fell(io_pin pin) {
+    return debounce_take_falling(IO_PIN_PORT(pin), IO_PIN_MASK(pin)) != 0;
+}
@@ -2,66 +2,173 @@
 
 #include <string.h>
 
+// Convenience macro for advancing an index over [0, 2 * data_size)
+#define QUEUE_NEXT_IDX(q, idx) (((idx) + 1U == 2U * (q)->data_size) ? 0 : (idx) + 1U)
+
+// Convenience macro for getting the slot in [0, data_size) of an element from its index
+#define QUEUE_SLOT(q, idx) (((idx) >= (q)->data_size) ? (idx) - (q)->data_size : (idx))
+
+// Convenience macro for getting the position in the data storage of an element from its index
+#define QUEUE_ELEMENT(q, idx) (&(q)->data[QUEUE_SLOT(q, idx) * (q)->element_size])
+
+// Return the number of elements between the given indices
+static size_t queue_distance(const queue *q, uint8_t head_idx, uint8_t tail_idx) {
+    if (head_idx >= tail_idx) return head_idx - tail_idx;
+
+    return 2U * q->data_size - tail_idx + head_idx;
+}
+
+// Return the index count elements after the given index
+static uint8_t queue_advance(const queue *q, uint8_t idx, size_t count) {
+    size_t next = idx + count;
+
+    return (next >= 2U * q->data_size) ? next - 2U * q->data_size : next;
+}
+
 void queue_enqueue(queue *q, const void *data) {
+    if (!q || !data) return;
+
+    // Read the consumer's index once; it can only move forward (i.e. free up space) from here
+    uint8_t head_idx = q->head_idx;
+    uint8_t tail_idx = q->tail_idx;
+
     // If the queue is full, do nothing
-    if (!q || !data || queue_is_full(q)) return;
+    if (queue_distance(q, head_idx, tail_idx) == q->data_size) return;
 
     // Enqueue the data
-    memcpy(&q->data[q->head_idx * q->element_size], data, q->element_size);
-
-    // Wrap around if the head_idx is at the end of the queue
-    q->head_idx = (q->head_idx + 1 == q->data_size) ? 0 : q->head_idx + 1;
+    memcpy(QUEUE_ELEMENT(q, head_idx), data, q->element_size);
 
-    // If the head_idx is equal to the tail_idx, the queue is full
-    if (q->head_idx == q->tail_idx) q->is_full = true;
+    // Publish the element to the consumer
+    QUEUE_COMPILER_BARRIER();
+    q->head_idx = QUEUE_NEXT_IDX(q, head_idx);
 }
 
 void queue_dequeue(queue *q, void *o_data) {
-    // If the queue is empty, return 0
-    if (!q || !o_data || queue_is_empty(q)) {
-        o_data = NULL;
-        return;
-    }
+    if (!q || !o_data) return;
 
-    // Dequeue the data
-    memcpy(o_data, &q->data[q->tail_idx * q->element_size], q->element_size);
+    // Read the producer's index once; it can only move forward (i.e. add elements) from here
+    uint8_t tail_idx = q->tail_idx;
+
+    // If the queue is empty, do nothing
+    if (q->head_idx == tail_idx) return;
 
-    // Wrap around if the tail_idx is at the end of the queue
-    q->tail_idx = (q->tail_idx + 1 == q->data_size) ? 0 : q->tail_idx + 1;
+    // Dequeue the data
+    QUEUE_COMPILER_BARRIER();
+    memcpy(o_data, QUEUE_ELEMENT(q, tail_idx), q->element_size);
 
-    // If the head_idx is not equal to the tail_idx, the queue is not full
-    if (q->head_idx != q->tail_idx) q->is_full = false;
+    // Hand the slot back to the producer
+    QUEUE_COMPILER_BARRIER();
+    q->tail_idx = QUEUE_NEXT_IDX(q, tail_idx);
 }
 
 void queue_peek(const queue *q, void *o_data) {
-    // If the queue is empty, return 0
-    if (!q || !o_data || queue_is_empty(q)) {
-        o_data = NULL;
-        return;
-    }
+    if (!q || !o_data) return;
+
+    uint8_t tail_idx = q->tail_idx;
+
+    // If the queue is empty, do nothing
+    if (q->head_idx == tail_idx) return;
 
     // Peek at the data
-    memcpy(o_data, &q->data[q->tail_idx * q->element_size], q->element_size);
+    QUEUE_COMPILER_BARRIER();
+    memcpy(o_data, QUEUE_ELEMENT(q, tail_idx), q->element_size);
 }
 
-size_t queue_size(const volatile queue *q) {
-    if (!q) return 0;
+size_t queue_enqueue_n(queue *q, const void *data, size_t count) {
+    if (!q || !data) return 0;
+
+    const uint8_t *src = data;
+    size_t total       = 0;
+
+    // The free space wraps around the end of the storage at most once
+    for (uint8_t pass = 0; pass < 2 && total < count; pass++) {
+        size_t span;
+        void *dst = queue_reserve_write(q, &span);
+        if (span > count - total) span = count - total;
 
-    if (q->is_full) return q->data_size;
+        memcpy(dst, &src[total * q->element_size], span * q->element_size);
+        queue_commit_write(q, span);
+        total += span;
+    }
+
+    return total;
+}
 
-    if (q->head_idx >= q->tail_idx) return q->head_idx - q->tail_idx;
+size_t queue_dequeue_n(queue *q, void *o_data, size_t count) {
+    if (!q || !o_data) return 0;
+
+    uint8_t *dst = o_data;
+    size_t total = 0;
+
+    // The queued elements wrap around the end of the storage at most once
+    for (uint8_t pass = 0; pass < 2 && total < count; pass++) {
+        size_t span;
+        const void *src = queue_reserve_read(q, &span);
+        if (span > count - total) span = count - total;
+
+        memcpy(&dst[total * q->element_size], src, span * q->element_size);
+        queue_commit_read(q, span);
+        total += span;
+    }
+
+    return total;
+}
+
+void *queue_reserve_write(queue *q, size_t *o_count) {
+    if (!q || !o_count) return NULL;
+
+    uint8_t head_idx = q->head_idx;
+
+    // Free space runs from the head to the tail, or to the end of the storage if that comes first
+    size_t free_count = q->data_size - queue_distance(q, head_idx, q->tail_idx);
+    size_t contiguous = q->data_size - QUEUE_SLOT(q, head_idx);
+
+    *o_count = (free_count < contiguous) ? free_count : contiguous;
+    return QUEUE_ELEMENT(q, head_idx);
+}
+
+void queue_commit_write(queue *q, size_t count) {
+    if (!q) return;
+
+    QUEUE_COMPILER_BARRIER();
+    q->head_idx = queue_advance(q, q->head_idx, count);
+}
+
+const void *queue_reserve_read(const queue *q, size_t *o_count) {
+    if (!q || !o_count) return NULL;
+
+    uint8_t tail_idx = q->tail_idx;
+
+    // Elements run from the tail to the head, or to the end of the storage if that comes first
+    size_t used_count = queue_distance(q, q->head_idx, tail_idx);
+    size_t contiguous = q->data_size - QUEUE_SLOT(q, tail_idx);
+
+    *o_count = (used_count < contiguous) ? used_count : contiguous;
+    QUEUE_COMPILER_BARRIER();
+    return QUEUE_ELEMENT(q, tail_idx);
+}
+
+void queue_commit_read(queue *q, size_t count) {
+    if (!q) return;
+
+    QUEUE_COMPILER_BARRIER();
+    q->tail_idx = queue_advance(q, q->tail_idx, count);
+}
+
+size_t queue_size(const volatile queue *q) {
+    if (!q) return 0;
 
-    return q->data_size - q->tail_idx + q->head_idx;
+    return queue_distance(q, q->head_idx, q->tail_idx);
 }
 
 bool queue_is_empty(const volatile queue *q) {
     if (!q) return true;
 
-    return q->head_idx == q->tail_idx && !q->is_full;
+    return q->head_idx == q->tail_idx;
 }
 
 bool queue_is_full(const volatile queue *q) {
     if (!q) return false;
 
-    return q->is_full;
+    return queue_size(q) == q->data_size;
 }
@@ -0,0 +1,323 @@
+#define BSP_ASSERT_FILE_ID BSP_ASSERT_FILE_ID_I2C
+
+#include "bsp/i2c.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/twi.h>
+
+#include "bsp/dsa/queue.h"
+#include "bsp/idle.h"
+#include "bsp/io.h"
+#include "bsp/sched.h"
+#include "bsp/util/assert.h"
+
+#ifndef F_CPU
+#error "F_CPU must be defined to use the I2C driver."
+#endif
+
+// Note:
+// Writing TWCR with TWINT set (which clears the flag) tells the TWI to carry out the next bus
+// action, so TWCR cannot be read-modify-written to mask the TWI interrupt: a pending interrupt's
+// flag would be written back and cleared. The main loop disables interrupts globally instead, for
+// the few instructions that it shares the driver's state with the handler.
+
+// Configuration(s) --------------------------------------------------------------------------------
+
+// Initialization flag
+static bool i2c_initialized = false;
+
+#define assert_i2c_initialized() bsp_assert(i2c_initialized, "I2C has not been initialized.")
+
+// The TWI pins
+#define I2C_PIN_SDA BSP_PC4
+#define I2C_PIN_SCL BSP_PC5
+
+// TWCR values: continue with the next bus action, and add a START and/or STOP condition to it
+#define I2C_TWCR_CONTINUE (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+#define I2C_TWCR_START    (I2C_TWCR_CONTINUE | _BV(TWSTA))
+#define I2C_TWCR_STOP     (I2C_TWCR_CONTINUE | _BV(TWSTO))
+
+// Counters (written by the TWI interrupt)
+static i2c_stats i2c_counters = {0};
+
+// Transaction queue -------------------------------------------------------------------------------
+
+// The depth of the transaction queue (set by a meson option)
+#ifndef I2C_QUEUE_SIZE
+#define I2C_QUEUE_SIZE 4
+#endif
+
+// The queue holds descriptor pointers, like the SPI driver's (see spi.c)
+typedef i2c_transaction *i2c_transaction_ref;
+
+QUEUE_TYPED_DEFINE(i2c_transaction_queue, i2c_transaction_ref, I2C_QUEUE_SIZE);
+
+// The transaction on the bus stays at the front of the queue until it ends
+static i2c_transaction_queue i2c_queue;
+
+// Whether the bus is held for a transaction: set by the START that i2c_submit() issues on an idle
+// bus, and cleared by the STOP that ends the last queued transaction
+static volatile bool i2c_active = false;
+
+// Where the state machine is in the transaction on the bus: whether it is in master receiver mode
+// (the read phase, after the repeated START) rather than master transmitter mode, and the index of
+// the next byte of tx_buf to send, or of rx_buf to fill (only accessed by the TWI interrupt, or by
+// i2c_submit() with interrupts disabled)
+static uint8_t i2c_index = 0;
+static bool i2c_reading  = false;
+
+// Interrupt handlers ------------------------------------------------------------------------------
+
+/// @brief Reset the state machine for a transaction, which starts in master transmitter mode unless
+///        it only reads. The caller requests its START condition.
+static inline void i2c_begin(i2c_transaction *transaction) {
+    transaction->status = I2C_STATUS_ACTIVE;
+    i2c_index           = 0;
+    i2c_reading         = transaction->tx_length == 0;
+}
+
+/// @brief End the transaction on the bus with a status, count it, and answer the TWI with a STOP
+///        condition, followed by the START of the next queued transaction if there is one.
+static void i2c_end(i2c_transaction *transaction, i2c_status status) {
+    switch (status) {
+        case I2C_STATUS_DONE:
+            i2c_counters.transactions++;
+            break;
+        case I2C_STATUS_ADDRESS_NACK:
+            i2c_counters.address_nacks++;
+            break;
+        case I2C_STATUS_DATA_NACK:
+            i2c_counters.data_nacks++;
+            break;
+        case I2C_STATUS_ARBITRATION_LOST:
+            i2c_counters.arbitration_lost++;
+            break;
+        default:
+            i2c_counters.bus_errors++;
+            break;
+    }
+
+    // Release the descriptor's queue slot, so that its callback can resubmit it
+    i2c_transaction_queue_commit_read(&i2c_queue, 1);
+    transaction->status = status;
+
+    // After a lost arbitration the bus belongs to the other master, which sends its own STOP;
+    // otherwise release it. With TWSTA as well, the TWI sends the next START as soon as the bus is
+    // free.
+    uint8_t control = (status == I2C_STATUS_ARBITRATION_LOST) ? I2C_TWCR_CONTINUE : I2C_TWCR_STOP;
+
+    // Start the next queued transaction before running the callback, so that the bus does not wait
+    // for it. With none queued, the bus is only released after the callback, which can then queue
+    // one to follow straight on.
+    i2c_transaction *next = NULL;
+    bool started          = i2c_transaction_queue_peek(&i2c_queue, &next);
+
+    if (started) {
+        i2c_begin(next);
+        TWCR = control | _BV(TWSTA);
+    }
+
+    sched_post_from_isr(SCHED_EVENT_I2C);
+    if (BSP_ISR_CALLBACKS && transaction->on_complete) transaction->on_complete(transaction);
+
+    if (started) return;
+
+    if (i2c_transaction_queue_peek(&i2c_queue, &next)) {
+        i2c_begin(next);
+        control |= _BV(TWSTA);
+    } else {
+        i2c_active = false;
+    }
+
+    TWCR = control;
+}
+
+// Note:
+// Each TWI interrupt reports the outcome of the last bus action in TWSR, and the handler answers
+// with the next one by writing TWCR (and TWDR):
+// - START or repeated START sent: send the address, with W in the write phase and R in the read
+//   phase.
+// - Address+W or a data byte acknowledged (master transmitter): send the next byte of tx_buf. When
+//   none are left, turn the bus around with a repeated START if there is anything to read, or end.
+// - Address+R acknowledged, or a byte received and acknowledged (master receiver): store the byte,
+//   and acknowledge the next one unless it is the last. A NACK tells the device to stop sending.
+// - The last byte received and not acknowledged: store it and end.
+// - Address or data NACK, lost arbitration or a bus error: end with the matching status.
+
+/// @brief TWI interrupt handler. Triggered when the TWI has finished a bus action.
+ISR(TWI_vect) {
+    i2c_transaction *transaction = NULL;
+    uint8_t status               = TW_STATUS;
+
+    // With no transaction on the bus (a bus error, e.g. from noise, while idle), there is nothing
+    // to end: count a bus error and recover the TWI, with a STOP that only resets it
+    if (!i2c_active || !i2c_transaction_queue_peek(&i2c_queue, &transaction)) {
+        i2c_counters.bus_errors++;
+        TWCR = (status == TW_BUS_ERROR) ? I2C_TWCR_STOP : I2C_TWCR_CONTINUE;
+        return;
+    }
+
+    switch (status) {
+        case TW_START:
+        case TW_REP_START:
+            TWDR = (uint8_t)(transaction->address << 1) | (i2c_reading ? TW_READ : TW_WRITE);
+            TWCR = I2C_TWCR_CONTINUE;
+            break;
+
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (i2c_index < transaction->tx_length) {
+                TWDR = transaction->tx_buf[i2c_index++];
+                TWCR = I2C_TWCR_CONTINUE;
+            } else if (transaction->rx_length > 0) {
+                // Turn the bus around with a repeated start, without releasing it
+                i2c_index   = 0;
+                i2c_reading = true;
+                TWCR        = I2C_TWCR_START;
+            } else {
+                i2c_end(transaction, I2C_STATUS_DONE);
+            }
+            break;
+
+        case TW_MR_SLA_ACK:
+        case TW_MR_DATA_ACK:
+            if (status == TW_MR_DATA_ACK) transaction->rx_buf[i2c_index++] = TWDR;
+
+            // Acknowledge every byte but the last, which tells the device to stop sending
+            TWCR = I2C_TWCR_CONTINUE | ((i2c_index + 1 < transaction->rx_length) ? _BV(TWEA) : 0);
+            break;
+
+        case TW_MR_DATA_NACK:
+            transaction->rx_buf[i2c_index++] = TWDR;
+            i2c_end(transaction, I2C_STATUS_DONE);
+            break;
+
+        case TW_MT_SLA_NACK:
+        case TW_MR_SLA_NACK:
+            i2c_end(transaction, I2C_STATUS_ADDRESS_NACK);
+            break;
+
+        case TW_MT_DATA_NACK:
+            i2c_end(transaction, I2C_STATUS_DATA_NACK);
+            break;
+
+        case TW_MT_ARB_LOST:
+            i2c_end(transaction, I2C_STATUS_ARBITRATION_LOST);
+            break;
+
+        default:
+            // A bus error (or an unexpected state); the STOP that ends the transaction resets the
+            // TWI without sending anything
+            i2c_end(transaction, I2C_STATUS_BUS_ERROR);
+            break;
+    }
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void i2c_init(i2c_config config) {
+    bsp_assert(!i2c_initialized, "I2C has already been initialized.");
+    bsp_assert(config.frequency > 0, "I2C frequency must not be zero.");
+
+    // SCL runs at F_CPU / (16 + 2 * TWBR * prescaler); round the divider up, so that the bus is
+    // never faster than requested, and use the smallest prescaler (1, 4, 16 or 64) that fits TWBR
+    uint32_t divider = (F_CPU + config.frequency - 1) / config.frequency;
+    uint32_t twbr    = (divider > 16) ? (divider - 16 + 1) / 2 : 0;
+    uint8_t twps     = 0;
+
+    while (twbr > UINT8_MAX && twps < 3) {
+        twbr = (twbr + 3) / 4;
+        twps++;
+    }
+
+    bsp_assert(twbr <= UINT8_MAX, "I2C frequency is too low.");
+
+    TWSR = twps;
+    TWBR = (uint8_t)twbr;
+
+    io_configure_mask(IO_PORT_C,
+                      IO_PIN_MASK(I2C_PIN_SDA) | IO_PIN_MASK(I2C_PIN_SCL),
+                      (io_config){
+                          .direction = IO_DIRECTION_INPUT,
+                          .resistor  = config.internal_pullups ? IO_RESISTOR_PULLUP
+                                                               : IO_RESISTOR_FLOATING,
+                      });
+
+    // Enable the TWI and its interrupt
+    TWCR = _BV(TWEN) | _BV(TWIE);
+
+    // Set the initialization flag
+    i2c_initialized = true;
+}
+
+bool i2c_submit(i2c_transaction *transaction) {
+    assert_i2c_initialized();
+    bsp_assert(transaction->tx_length > 0 || transaction->rx_length > 0,
+               "I2C transactions must write or read something.");
+    bsp_assert(BSP_ISR_CALLBACKS || !transaction->on_complete, "ISR callbacks are disabled.");
+
+    // Disable interrupts (see the note above), which also serializes submissions from callbacks
+    uint8_t sreg = SREG;
+    cli();
+
+    bool queued = i2c_transaction_queue_enqueue(&i2c_queue, transaction);
+
+    if (queued) {
+        transaction->status = I2C_STATUS_QUEUED;
+
+        if (!i2c_active) {
+            i2c_active = true;
+            i2c_begin(transaction);
+
+            // The STOP that ended the last transaction takes about one SCL period to go out
+            while (TWCR & _BV(TWSTO)) {
+            }
+
+            TWCR = I2C_TWCR_START;
+        }
+    }
+
+    SREG = sreg;
+
+    return queued;
+}
+
+i2c_status i2c_transfer_blocking(i2c_transaction *transaction) {
+    // Sleep until a queue slot frees up, then until the state machine ends the transaction with
+    // any status past ACTIVE (completed or failed)
+    while (!i2c_submit(transaction)) {
+        idle_wait_while(i2c_transaction_queue_is_full(&i2c_queue));
+    }
+
+    while (transaction->status <= I2C_STATUS_ACTIVE) {
+        idle_wait_while(transaction->status <= I2C_STATUS_ACTIVE);
+    }
+
+    return transaction->status;
+}
+
+bool i2c_busy(void) {
+    return i2c_active;
+}
+
+i2c_stats i2c_get_stats(void) {
+    // The counters are wider than a byte; copy them with interrupts disabled (see the note above)
+    uint8_t sreg = SREG;
+    cli();
+
+    i2c_stats stats = i2c_counters;
+
+    SREG = sreg;
+
+    return stats;
+}
+
+void i2c_reset_stats(void) {
+    uint8_t sreg = SREG;
+    cli();
+
+    i2c_counters = (i2c_stats){0};
+
+    SREG = sreg;
+}
@@ -0,0 +1,31 @@
+#include "bsp/idle.h"
+
+#include <avr/sleep.h>
+#include <stddef.h>
+
+// The idle hook (initialized in idle_set_hook())
+static volatile idle_hook idle_current_hook = NULL;
+
+void idle_set_hook(idle_hook hook) {
+    idle_current_hook = hook;
+}
+
+void idle_wait(uint8_t sreg) {
+    idle_hook hook = idle_current_hook;
+
+    // Nothing could wake the CPU with interrupts disabled; return to spinning
+    if (hook || !(sreg & _BV(SREG_I))) {
+        SREG = sreg;
+        if (hook) hook();
+        return;
+    }
+
+    // sei() takes effect after the next instruction, so no interrupt can run between it and the
+    // sleep instruction: an interrupt that became pending after the caller's check wakes the CPU
+    // right away
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+}
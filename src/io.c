@@ -2,69 +2,72 @@
 
 #include <avr/io.h>
 
+#include "io_registers.h"
+
 /// The output data register for each IO port
 static volatile uint8_t *const PORT_REGISTERS[] = {&PORTB, &PORTC, &PORTD};
 
 /// The data direction register for each IO port
 static volatile uint8_t *const DDR_REGISTERS[] = {&DDRB, &DDRC, &DDRD};
 
-/// The input data register for each IO port
-static volatile uint8_t *const PIN_REGISTERS[] = {&PINB, &PINC, &PIND};
-
-// Convenience macro for getting the port index from a pin number
-#define PORT_MASK     0x18
-#define PORT_OFFSET   3
-#define PORT_IDX(pin) (((pin)&PORT_MASK) >> PORT_OFFSET)
+/// The input data register for each IO port (shared with io_event.c, see io_registers.h)
+volatile uint8_t *const io_pin_registers[] = {&PINB, &PINC, &PIND};
 
-// Convenience macro for getting the pin index from a pin number
-#define PIN_MASK     0x07
-#define PIN_IDX(pin) ((pin)&PIN_MASK)
+// Convenience macros for getting the port and pin index from a pin number (see bsp/io.h)
+#define PORT_IDX(pin) IO_PORT_IDX(pin)
+#define PIN_IDX(pin)  IO_PIN_IDX(pin)
 
 // Convenience macros for getting a register from a pin number
 #define PORT_REGISTER(pin) *PORT_REGISTERS[PORT_IDX(pin)]
-#define DDR_REGISTER(pin)  *DDR_REGISTERS[PORT_IDX(pin)]
-#define PIN_REGISTER(pin)  *PIN_REGISTERS[PORT_IDX(pin)]
+#define PIN_REGISTER(pin)  *io_pin_registers[PORT_IDX(pin)]
 
 void io_configure(io_pin pin, io_config config) {
+    io_configure_mask(IO_PIN_PORT(pin), _BV(PIN_IDX(pin)), config);
+}
+
+void io_configure_mask(io_port port, uint8_t mask, io_config config) {
+    volatile uint8_t *port_register = PORT_REGISTERS[port];
+    volatile uint8_t *ddr_register  = DDR_REGISTERS[port];
+
     switch (config.direction) {
         case IO_DIRECTION_INPUT:
-            // Set the pin up as an input
-            DDR_REGISTER(pin) &= ~_BV(PIN_IDX(pin));
+            // Set the pins up as inputs
+            *ddr_register &= ~mask;
 
-            // Set the pin's resistor
+            // Set the pins' resistors
             switch (config.resistor) {
                 case IO_RESISTOR_FLOATING:
-                    PORT_REGISTER(pin) &= ~_BV(PIN_IDX(pin));
+                    *port_register &= ~mask;
                     break;
                 case IO_RESISTOR_PULLUP:
-                    PORT_REGISTER(pin) |= _BV(PIN_IDX(pin));
+                    *port_register |= mask;
                     break;
             }
             break;
         case IO_DIRECTION_OUTPUT:
-            // Set the pin up as an output
-            DDR_REGISTER(pin) |= _BV(PIN_IDX(pin));
+            // Set the pins up as outputs
+            *ddr_register |= mask;
 
-            // Set the pin's initial level
+            // Set the pins' initial level
             switch (config.initial_level) {
                 case IO_LOW:
-                    PORT_REGISTER(pin) &= ~_BV(PIN_IDX(pin));
+                    *port_register &= ~mask;
                     break;
                 case IO_HIGH:
-                    PORT_REGISTER(pin) |= _BV(PIN_IDX(pin));
+                    *port_register |= mask;
                     break;
             }
             break;
     }
 }
 
-io_logic_level io_read(io_pin pin) {
+io_logic_level io_read_dynamic(io_pin pin) {
     //? Note(Caleb): Should we assert that this is an input pin?
 
     return (PIN_REGISTER(pin) & _BV(PIN_IDX(pin))) ? IO_HIGH : IO_LOW;
 }
 
-void io_write(io_pin pin, io_logic_level level) {
+void io_write_dynamic(io_pin pin, io_logic_level level) {
     //? Note(Caleb): Should we assert that this is an output pin?
 
     switch (level) {
@@ -77,8 +80,24 @@ void io_write(io_pin pin, io_logic_level level) {
     }
 }
 
-void io_toggle(io_pin pin) {
+void io_toggle_dynamic(io_pin pin) {
     //? Note(Caleb): Should we assert that this is an output pin?
 
-    PORT_REGISTER(pin) ^= _BV(PIN_IDX(pin));
+    // A single write, so unlike a read-modify-write of PORTx, an interrupt can't corrupt it
+    IO_HW_TOGGLE(PORT_REGISTER(pin), PIN_REGISTER(pin), _BV(PIN_IDX(pin)));
+}
+
+uint8_t io_read_port_dynamic(io_port port) {
+    return *io_pin_registers[port];
+}
+
+void io_write_mask_dynamic(io_port port, uint8_t mask, uint8_t value) {
+    // Toggle only the selected pins that differ from value (see bsp/io.h)
+    uint8_t toggle = (uint8_t)((*PORT_REGISTERS[port] ^ value) & mask);
+
+    IO_HW_TOGGLE(*PORT_REGISTERS[port], *io_pin_registers[port], toggle);
+}
+
+void io_toggle_mask_dynamic(io_port port, uint8_t mask) {
+    IO_HW_TOGGLE(*PORT_REGISTERS[port], *io_pin_registers[port], mask);
 }
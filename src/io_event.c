@@ -0,0 +1,186 @@
+#include "bsp/io_event.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stddef.h>
+
+#include "bsp/sched.h"
+#include "bsp/util/assert.h"
+#include "io_registers.h"
+
+// Note:
+// The callback table is indexed by io_pin, whose encoding ([ port index | pin index ]) makes the
+// callbacks of each port a contiguous run of 8 entries.
+
+// The number of IO ports (B, C and D)
+#define IO_EVENT_PORT_COUNT 3
+
+// The callback of each pin (initialized in io_event_register())
+static io_event_callback io_event_callbacks[IO_EVENT_PORT_COUNT * 8] = {NULL};
+
+// The pins of each port that report rising and falling edges through its pin change interrupt
+static uint8_t io_event_rising[IO_EVENT_PORT_COUNT]  = {0};
+static uint8_t io_event_falling[IO_EVENT_PORT_COUNT] = {0};
+
+// The input levels of each port when its pin change interrupt last ran (only accessed by the
+// interrupt, or with it masked)
+static uint8_t io_event_last[IO_EVENT_PORT_COUNT] = {0};
+
+/// The pin change mask register for each IO port
+static volatile uint8_t *const PCMSK_REGISTERS[] = {&PCMSK0, &PCMSK1, &PCMSK2};
+
+// Interrupt handlers ------------------------------------------------------------------------------
+
+/// @brief Call the callbacks of the pins of a port whose registered edges occurred since the last
+///        call.
+static inline void io_event_dispatch(uint8_t port, uint8_t levels) {
+    uint8_t changed     = levels ^ io_event_last[port];
+    io_event_last[port] = levels;
+
+    // Only the changed pins whose new level matches a registered edge
+    uint8_t events = (changed & levels & io_event_rising[port]) |
+                     (changed & (uint8_t)~levels & io_event_falling[port]);
+
+    if (!events) return;
+
+    sched_post_from_isr(SCHED_EVENT_IO_EDGE);
+    if (!BSP_ISR_CALLBACKS) return;
+
+    io_event_callback *callbacks = &io_event_callbacks[port * 8];
+
+    for (uint8_t pin_idx = 0; events; pin_idx++, events >>= 1, levels >>= 1) {
+        if (!(events & 1) || !callbacks[pin_idx]) continue;
+
+        callbacks[pin_idx]((io_pin)(port * 8 + pin_idx), (levels & 1) ? IO_HIGH : IO_LOW);
+    }
+}
+
+/// @brief External interrupt 0 handler (BSP_PD2).
+ISR(INT0_vect) {
+    sched_post_from_isr(SCHED_EVENT_IO_EDGE);
+
+    io_event_callback callback = io_event_callbacks[BSP_PD2];
+    if (BSP_ISR_CALLBACKS && callback) callback(BSP_PD2, io_read(BSP_PD2));
+}
+
+/// @brief External interrupt 1 handler (BSP_PD3).
+ISR(INT1_vect) {
+    sched_post_from_isr(SCHED_EVENT_IO_EDGE);
+
+    io_event_callback callback = io_event_callbacks[BSP_PD3];
+    if (BSP_ISR_CALLBACKS && callback) callback(BSP_PD3, io_read(BSP_PD3));
+}
+
+/// @brief Pin change interrupt 0 handler (port B).
+ISR(PCINT0_vect) {
+    io_event_dispatch(IO_PORT_B, PINB);
+}
+
+/// @brief Pin change interrupt 1 handler (port C).
+ISR(PCINT1_vect) {
+    io_event_dispatch(IO_PORT_C, PINC);
+}
+
+/// @brief Pin change interrupt 2 handler (port D).
+ISR(PCINT2_vect) {
+    io_event_dispatch(IO_PORT_D, PIND);
+}
+
+// External interrupts -----------------------------------------------------------------------------
+
+/// @brief Return the external interrupt number of a pin, or -1 if it has none.
+static int8_t io_event_external_interrupt(io_pin pin) {
+    switch (pin) {
+        case BSP_PD2:
+            return 0;
+        case BSP_PD3:
+            return 1;
+        default:
+            return -1;
+    }
+}
+
+/// @brief Configure and enable (or, without an edge, disable) an external interrupt.
+static void io_event_configure_external(uint8_t interrupt, io_edge edge) {
+    // Disable the interrupt while its sense control changes, which can trigger it
+    EIMSK &= (uint8_t)~_BV(interrupt);
+
+    if (!edge) return;
+
+    // Sense control (ISCn1:ISCn0): 01 for any change, 10 for falling and 11 for rising edges
+    uint8_t sense = (edge == IO_EDGE_BOTH) ? 0x01 : (edge == IO_EDGE_FALLING) ? 0x02 : 0x03;
+    uint8_t shift = interrupt * 2;
+
+    EICRA = (uint8_t)((EICRA & ~(0x03 << shift)) | (sense << shift));
+
+    // Clear any edge latched in the meantime (by writing a one to its flag), then enable
+    EIFR  = _BV(interrupt);
+    EIMSK |= _BV(interrupt);
+}
+
+// Pin change interrupts ---------------------------------------------------------------------------
+
+/// @brief Set the edges that a pin reports through its port's pin change interrupt (none to stop
+///        watching it).
+static void io_event_configure_pin_change(io_pin pin, uint8_t edge) {
+    uint8_t port = IO_PORT_IDX(pin);
+    uint8_t mask = IO_PIN_MASK(pin);
+
+    // Mask the port's interrupt, the only other user of its state, while updating it
+    PCICR &= (uint8_t)~_BV(port);
+
+    bool watched = *PCMSK_REGISTERS[port];
+
+    io_event_rising[port]  = (edge & IO_EDGE_RISING) ? (io_event_rising[port] | mask)
+                                                     : (io_event_rising[port] & ~mask);
+    io_event_falling[port] = (edge & IO_EDGE_FALLING) ? (io_event_falling[port] | mask)
+                                                      : (io_event_falling[port] & ~mask);
+
+    if (edge) {
+        *PCMSK_REGISTERS[port] |= mask;
+    } else {
+        *PCMSK_REGISTERS[port] &= (uint8_t)~mask;
+    }
+
+    // Start from the pin's current level so that its existing state is not reported as an edge.
+    // The other pins keep their last levels, so that an edge on one of them that is still pending
+    // (or that arrived while the interrupt was masked) is reported when it is unmasked.
+    io_event_last[port] = (io_event_last[port] & ~mask) | (*io_pin_registers[port] & mask);
+
+    if (*PCMSK_REGISTERS[port]) {
+        // A change latched before any pin of the port was watched is stale
+        if (!watched) PCIFR = _BV(port);
+        PCICR |= _BV(port);
+    }
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void io_event_register(io_pin pin, io_edge edge, io_event_callback callback) {
+    bsp_assert(BSP_ISR_CALLBACKS || !callback, "ISR callbacks are disabled.");
+
+    int8_t interrupt = io_event_external_interrupt(pin);
+
+    if (interrupt >= 0) {
+        // Disable the interrupt before replacing the callback it calls
+        io_event_configure_external((uint8_t)interrupt, 0);
+        io_event_callbacks[pin] = callback;
+        io_event_configure_external((uint8_t)interrupt, edge);
+    } else {
+        io_event_configure_pin_change(pin, 0);
+        io_event_callbacks[pin] = callback;
+        io_event_configure_pin_change(pin, edge);
+    }
+}
+
+void io_event_unregister(io_pin pin) {
+    int8_t interrupt = io_event_external_interrupt(pin);
+
+    if (interrupt >= 0) {
+        io_event_configure_external((uint8_t)interrupt, 0);
+    } else {
+        io_event_configure_pin_change(pin, 0);
+    }
+
+    io_event_callbacks[pin] = NULL;
+}
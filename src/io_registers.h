@@ -0,0 +1,12 @@
+#ifndef _CALEBRJC_BSP_IO_REGISTERS_H_
+#define _CALEBRJC_BSP_IO_REGISTERS_H_
+
+#include <stdint.h>
+
+// Register tables shared by the IO drivers (io.c and io_event.c), indexed by io_port. They are not
+// part of the public API.
+
+/// The input data register for each IO port (defined in io.c)
+extern volatile uint8_t *const io_pin_registers[];
+
+#endif  // _CALEBRJC_BSP_IO_REGISTERS_H_
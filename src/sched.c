@@ -0,0 +1,49 @@
+#include "bsp/sched.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stddef.h>
+
+#include "bsp/idle.h"
+
+volatile sched_events sched_pending = 0;
+
+// The task table (initialized in sched_init())
+static const sched_task *sched_tasks = NULL;
+static uint8_t sched_task_count      = 0;
+
+void sched_init(const sched_task *tasks, uint8_t count) {
+    sched_tasks      = tasks;
+    sched_task_count = count;
+}
+
+void sched_post(sched_events events) {
+    // The events are wider than a byte and may also be posted from any interrupt handler
+    uint8_t sreg = SREG;
+    cli();
+    sched_pending |= events;
+    SREG = sreg;
+}
+
+bool sched_run_once(void) {
+    uint8_t sreg = SREG;
+    cli();
+    sched_events events = sched_pending;
+    sched_pending       = 0;
+    SREG                = sreg;
+
+    if (!events) return false;
+
+    for (uint8_t i = 0; i < sched_task_count; i++) {
+        sched_events task_events = sched_tasks[i].events & events;
+        if (task_events) sched_tasks[i].run(task_events);
+    }
+
+    return true;
+}
+
+void sched_run(void) {
+    for (;;) {
+        if (!sched_run_once()) idle_wait_while(sched_pending == 0);
+    }
+}
@@ -0,0 +1,179 @@
+#define BSP_ASSERT_FILE_ID BSP_ASSERT_FILE_ID_SPI
+
+#include "bsp/spi.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "bsp/dsa/queue.h"
+#include "bsp/idle.h"
+#include "bsp/sched.h"
+#include "bsp/util/assert.h"
+
+// Configuration(s) --------------------------------------------------------------------------------
+
+// Initialization flag
+static bool spi_initialized = false;
+
+#define assert_spi_initialized() bsp_assert(spi_initialized, "SPI has not been initialized.")
+
+// The SPI pins
+#define SPI_PIN_SS   BSP_PB2
+#define SPI_PIN_MOSI BSP_PB3
+#define SPI_PIN_MISO BSP_PB4
+#define SPI_PIN_SCK  BSP_PB5
+
+// Transfer queue ----------------------------------------------------------------------------------
+
+// The number of transfers that can be queued (set by a meson option)
+#ifndef SPI_QUEUE_SIZE
+#define SPI_QUEUE_SIZE 4
+#endif
+
+// Queued transfers are referenced by pointer (through a typedef, so that the queue's "const T *"
+// qualifies the pointer rather than the transfer)
+typedef spi_transfer *spi_transfer_ref;
+
+QUEUE_TYPED_DEFINE(spi_transfer_queue, spi_transfer_ref, SPI_QUEUE_SIZE);
+
+// The queued transfers, the one in progress first. spi_submit() masks the SPI interrupt while it
+// enqueues, so that callbacks (which run in the interrupt) can submit transfers as well.
+static spi_transfer_queue spi_queue;
+
+// Whether the SPI interrupt is running the transfer at the front of the queue (set by
+// spi_submit() with the interrupt masked, and cleared by the interrupt once the queue is empty)
+static volatile bool spi_active = false;
+
+// The index of the byte being exchanged in the transfer in progress (only accessed by the SPI
+// interrupt, or by spi_submit() with it masked)
+static uint16_t spi_index = 0;
+
+// Whether the last transfer left its chip select low (see spi_transfer.cs_hold)
+static bool spi_cs_held = false;
+
+// Interrupt handlers ------------------------------------------------------------------------------
+
+/// @brief Start a transfer, selecting its device and sending its first byte.
+static inline void spi_start(spi_transfer *transfer) {
+    // Chip selects are driven to a level rather than toggled, so that one that was left low
+    // cannot end up inverted. The write is a read-modify-write of PORTx, so when the main loop
+    // starts a transfer (with only the SPI interrupt masked), disable interrupts for it, or an
+    // interrupt that writes another pin of the port could be undone.
+    if (!spi_cs_held) {
+        uint8_t sreg = SREG;
+        cli();
+
+        io_write(transfer->cs_pin, IO_LOW);
+
+        SREG = sreg;
+    }
+
+    transfer->status = SPI_STATUS_ACTIVE;
+    spi_index        = 0;
+
+    SPDR = transfer->tx_buf ? transfer->tx_buf[0] : SPI_FILL_BYTE;
+}
+
+/// @brief Serial transfer complete interrupt handler. Triggered when a byte has been exchanged.
+ISR(SPI_STC_vect) {
+    // The transfer in progress is at the front of the queue while the interrupt is enabled
+    spi_transfer *transfer = NULL;
+    spi_transfer_queue_peek(&spi_queue, &transfer);
+
+    uint8_t data   = SPDR;
+    uint16_t index = spi_index + 1;
+
+    if (index < transfer->length) {
+        // Keep the bus busy: send the next byte before storing the one received
+        SPDR      = transfer->tx_buf ? transfer->tx_buf[index] : SPI_FILL_BYTE;
+        spi_index = index;
+
+        if (transfer->rx_buf) transfer->rx_buf[index - 1] = data;
+        return;
+    }
+
+    if (transfer->rx_buf) transfer->rx_buf[index - 1] = data;
+
+    // Release the device, and complete the transfer (dequeuing it first, so that its callback can
+    // submit it again)
+    spi_cs_held = transfer->cs_hold;
+    if (!spi_cs_held) io_write(transfer->cs_pin, IO_HIGH);
+
+    spi_transfer_queue_commit_read(&spi_queue, 1);
+    transfer->status = SPI_STATUS_DONE;
+
+    // Start the next transfer before running the callback, so that the bus does not wait for it
+    spi_transfer *next = NULL;
+
+    if (spi_transfer_queue_peek(&spi_queue, &next)) {
+        spi_start(next);
+    } else {
+        spi_active = false;
+    }
+
+    sched_post_from_isr(SCHED_EVENT_SPI);
+    if (BSP_ISR_CALLBACKS && transfer->on_complete) transfer->on_complete(transfer);
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void spi_init(spi_config config) {
+    bsp_assert(!spi_initialized, "SPI has already been initialized.");
+
+    // SS must stay an output (or the SPI drops out of master mode when it is driven low); it starts
+    // high, so that it can be used as a chip select
+    io_configure(SPI_PIN_SS,
+                 (io_config){.direction = IO_DIRECTION_OUTPUT, .initial_level = IO_HIGH});
+    io_configure_mask(IO_PORT_B,
+                      IO_PIN_MASK(SPI_PIN_MOSI) | IO_PIN_MASK(SPI_PIN_SCK),
+                      (io_config){.direction = IO_DIRECTION_OUTPUT});
+    io_configure(SPI_PIN_MISO, (io_config){.direction = IO_DIRECTION_INPUT});
+
+    // Set the clock rate, mode and bit order, and enable the SPI and its interrupt
+    SPSR = (config.clock & 0x04) ? _BV(SPI2X) : 0;
+    SPCR = _BV(SPIE) | _BV(SPE) | _BV(MSTR) | (config.lsb_first ? _BV(DORD) : 0) |
+           (uint8_t)((config.mode & 0x03) << CPHA) | (config.clock & 0x03);
+
+    // Set the initialization flag
+    spi_initialized = true;
+}
+
+bool spi_submit(spi_transfer *transfer) {
+    assert_spi_initialized();
+    bsp_assert(transfer->length > 0, "SPI transfers must not be empty.");
+    bsp_assert(BSP_ISR_CALLBACKS || !transfer->on_complete, "ISR callbacks are disabled.");
+
+    // Mask the SPI interrupt, the queue's consumer (and, through callbacks, its other producer)
+    uint8_t spcr = SPCR;
+    SPCR         = spcr & ~_BV(SPIE);
+
+    bool queued = spi_transfer_queue_enqueue(&spi_queue, transfer);
+
+    if (queued) {
+        transfer->status = SPI_STATUS_QUEUED;
+
+        if (!spi_active) {
+            spi_active = true;
+            spi_start(transfer);
+        }
+    }
+
+    SPCR = spcr;
+
+    return queued;
+}
+
+void spi_transfer_blocking(spi_transfer *transfer) {
+    // Wait for room in the queue, then for the transfer to complete
+    while (!spi_submit(transfer)) {
+        idle_wait_while(spi_transfer_queue_is_full(&spi_queue));
+    }
+
+    while (transfer->status != SPI_STATUS_DONE) {
+        idle_wait_while(transfer->status != SPI_STATUS_DONE);
+    }
+}
+
+bool spi_busy(void) {
+    return spi_active;
+}
@@ -1,9 +1,18 @@
+#define BSP_ASSERT_FILE_ID BSP_ASSERT_FILE_ID_USART
+
 #include "bsp/usart.h"
 
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
 #include <printf.h>
+#include <string.h>
+#include <util/crc16.h>
 
+#include "bsp/clock.h"
 #include "bsp/dsa/queue.h"
+#include "bsp/idle.h"
+#include "bsp/io_event.h"
+#include "bsp/sched.h"
 #include "bsp/util/assert.h"
 
 #ifndef F_CPU
@@ -17,11 +26,6 @@
 // referenced directly instead of some other mechanism (e.g. an array of registers, switch
 // statements, and/or macros) to avoid unnecessary overhead and complexity.
 
-// Baud rate calculation macros
-#define UBRR(baud)  ((F_CPU / (16UL * baud)) - 1)
-#define UBRRH(baud) ((uint8_t)(UBRR(baud) >> 8))
-#define UBRRL(baud) ((uint8_t)UBRR(baud))
-
 // Configuration(s) --------------------------------------------------------------------------------
 
 // Initialization flag
@@ -30,53 +34,683 @@ static bool usart0_initialized = false;
 #define assert_usart0_initialized() \
     bsp_assert(usart0_initialized, "USART0 has not been initialized.")
 
+// The per-byte functions (usart_poll(), usart_read(), usart_write() and _putchar()) only check for
+// initialization at the full assert level; in production builds, the check is left to the
+// functions that are called once per buffer, line or configuration change
+#define assert_usart0_initialized_debug() \
+    bsp_assert_debug(usart0_initialized, "USART0 has not been initialized.")
+
 // USART0 configuration (initialized in usart_init())
 static usart_config usart0_config = {0};
 
+// USART0 baud rate register setting (initialized in usart_init())
+static usart_baud_setting usart0_baud = {0};
+
 // USART0 callback function (initialized in usart_register_callback())
 static usart_recv_callback usart0_callback = NULL;
 
+// USART0 frame callback function (initialized in usart_register_frame_callback())
+static usart_frame_callback usart0_frame_callback = NULL;
+
+// Statistics --------------------------------------------------------------------------------------
+
+// Counting is compiled out entirely unless BSP_USART_STATS is set (by the usart_stats meson option)
+#if BSP_USART_STATS
+static usart_stats usart0_stats = {0};
+
+#define usart0_stats_add(field, n) (usart0_stats.field += (n))
+#define usart0_stats_max(field, value)                                \
+    do {                                                              \
+        uint8_t _value = (value);                                     \
+        if (_value > usart0_stats.field) usart0_stats.field = _value; \
+    } while (0)
+#else
+#define usart0_stats_add(field, n)     ((void)0)
+#define usart0_stats_max(field, value) ((void)0)
+#endif
+
+// Frame tracking ----------------------------------------------------------------------------------
+
+// Like the RX buffer, these are shared between the RX interrupt and the main loop without disabling
+// interrupts: each counter is a single byte written from one side only.
+
+// The number of bytes received into the current frame (written by the RX interrupt, or by
+// usart_rx_tick() with interrupts disabled)
+static volatile uint8_t usart0_rx_frame_length = 0;
+
+// The number of bytes received in total, modulo 256 (written by the RX interrupt)
+static volatile uint8_t usart0_rx_byte_count = 0;
+
+// The number of lines received and consumed, modulo 256 (written by the RX interrupt and
+// usart_readline() respectively)
+static volatile uint8_t usart0_rx_lines_received = 0;
+static volatile uint8_t usart0_rx_lines_consumed = 0;
+
+// Idle detection state (only accessed by usart_rx_tick())
+static uint8_t usart0_rx_idle_last_count = 0;
+static uint8_t usart0_rx_idle_ticks      = 0;
+
 // RX and TX Buffers -------------------------------------------------------------------------------
 
-#define USART0_BUFFER_SIZE 16
+// Default buffer sizes, used when usart_config does not provide storage (set by meson options)
+#ifndef USART0_RX_BUFFER_SIZE
+#define USART0_RX_BUFFER_SIZE 16
+#endif
+
+#ifndef USART0_TX_BUFFER_SIZE
+#define USART0_TX_BUFFER_SIZE 16
+#endif
+
+QUEUE_TYPED_DEFINE_EXTERNAL(usart_buffer, char);
+
+static usart_buffer usart0_rx_queue;
+static usart_buffer usart0_tx_queue;
+
+// A size of 0 leaves out the default storage, for applications that always provide their own (or
+// never use that direction)
+#if USART0_RX_BUFFER_SIZE > 0
+static char usart0_rx_storage[USART0_RX_BUFFER_SIZE];
+#define USART0_RX_DEFAULT_STORAGE usart0_rx_storage
+#else
+#define USART0_RX_DEFAULT_STORAGE NULL
+#endif
+
+#if USART0_TX_BUFFER_SIZE > 0
+static char usart0_tx_storage[USART0_TX_BUFFER_SIZE];
+#define USART0_TX_DEFAULT_STORAGE usart0_tx_storage
+#else
+#define USART0_TX_DEFAULT_STORAGE NULL
+#endif
+
+// Echoed bytes are produced by the RX interrupt, which can neither wait for space in the TX buffer
+// (the UDRE interrupt cannot drain it until the RX interrupt returns) nor enqueue into it (the main
+// loop is its only producer). They go straight to UDR0 when it is free, and into this small queue
+// otherwise, which the UDRE interrupt sends ahead of the TX buffer; echoes that do not fit are
+// dropped.
+#define USART0_ECHO_BUFFER_SIZE 4
+
+QUEUE_TYPED_DEFINE(usart_echo_buffer, char, USART0_ECHO_BUFFER_SIZE);
+
+static usart_echo_buffer usart0_echo_queue;
+
+// Framing -----------------------------------------------------------------------------------------
+
+// The number of received frames that can wait to be read (their payloads wait in the RX buffer)
+#define USART0_FRAME_QUEUE_SIZE 4
+
+QUEUE_TYPED_DEFINE(usart_frame_queue, uint8_t, USART0_FRAME_QUEUE_SIZE);
+
+// The payload lengths of the received frames waiting in the RX buffer, in order
+static usart_frame_queue usart0_frame_queue;
+
+// CRC-16/CCITT-FALSE, as computed by avr-libc's _crc_xmodem_update(). Running the CRC over a
+// payload followed by its CRC (most significant byte first) leaves 0, so frames are checked without
+// knowing where the payload ends.
+#define USART_FRAME_CRC_INIT 0xFFFF
+
+// The longest run of non-zero bytes in a COBS block (whose code byte is then 0xFF)
+#define USART_COBS_MAX_RUN 254
+
+#define USART_COBS_DELIMITER 0x00
+
+#define USART_SLIP_END     0xC0
+#define USART_SLIP_ESC     0xDB
+#define USART_SLIP_ESC_END 0xDC
+#define USART_SLIP_ESC_ESC 0xDD
+
+// The state of the frame being decoded by the RX interrupt
+typedef struct {
+    // The CRC of the bytes staged so far
+    uint16_t crc;
+
+    // The number of bytes staged in the RX buffer, including the CRC
+    uint8_t length;
+
+    // The code byte of the current COBS block (0xFF at the start of a frame, which implies no zero)
+    uint8_t cobs_code;
+
+    // The number of bytes left in the current COBS block
+    uint8_t cobs_remaining;
+
+    // Whether the previous byte was a SLIP escape
+    bool escaped;
+
+    // Whether the frame has an encoding or line error
+    bool invalid;
+
+    // Whether the frame did not fit in the RX buffer
+    bool dropped;
+} usart_frame_decoder;
+
+// Only accessed by the RX interrupt, or with it masked
+static usart_frame_decoder usart0_frame_decoder;
+
+// A frame being sent: its payload, followed by its CRC
+typedef struct {
+    const uint8_t *payload;
+    size_t length;
+    uint8_t crc[2];
+} usart_tx_frame;
+
+// Whether the last frame sent was cut short by a full TX buffer (see usart_frame_write())
+static bool usart0_tx_frame_broken = false;
+
+// Flow control ------------------------------------------------------------------------------------
 
-QUEUE_DECLARE_STATIC(usart0_rx_queue, char, USART0_BUFFER_SIZE);
-QUEUE_DECLARE_STATIC(usart0_tx_queue, char, USART0_BUFFER_SIZE);
+// Whether RTS is deasserted. Only the RX interrupt deasserts RTS and only the main loop asserts it
+// again, so each side only writes the flag while the other leaves it alone.
+static volatile bool usart0_rts_paused = false;
+
+// The RX buffer levels at which RTS is deasserted and asserted again (set by
+// usart_set_flow_control())
+static uint8_t usart0_rts_high_water = 0;
+static uint8_t usart0_rts_low_water  = 0;
+
+// A buffer that usart_vprintf() renders output into, through _putchar(), and enqueues in bulk each
+// time that it fills up
+typedef struct {
+    char *data;
+    uint8_t capacity;
+    uint8_t length;
+
+    // The number of bytes accepted into the TX buffer so far
+    size_t written;
+} usart_printf_chunk;
+
+// The chunk of the usart_vprintf() call in progress, or NULL outside of one (when _putchar()
+// enqueues each character directly). Each call saves and restores it, so that a call from an
+// interrupt handler in the middle of another renders into its own chunk.
+static usart_printf_chunk *usart0_printf_chunk = NULL;
 
 // Interrupt handlers ------------------------------------------------------------------------------
 
+/// @brief Return true if CTS tells the USART to pause transmission.
+static inline bool usart0_cts_paused(void) {
+    const usart_flow_control *flow_control = &usart0_config.flow_control;
+
+    return flow_control->cts_enabled && io_read(flow_control->cts_pin) == IO_HIGH;
+}
+
+/// @brief Return true if there are bytes waiting to be sent.
+static inline bool usart0_tx_pending(void) {
+    return !usart_buffer_is_empty(&usart0_tx_queue) ||
+           !usart_echo_buffer_is_empty(&usart0_echo_queue);
+}
+
+/// @brief Resume transmission when CTS is asserted. Called from the interrupt that watches the CTS
+///        pin (see bsp/io_event.h).
+static void usart0_cts_resume(io_pin pin, io_logic_level level) {
+    (void)pin;
+    (void)level;
+
+    if (usart0_tx_pending()) UCSR0B |= _BV(UDRIE0);
+}
+
+/// @brief Deassert RTS if the RX buffer has reached its high-water mark. Called from the RX
+///        interrupt.
+static inline void usart0_rts_throttle(void) {
+    if (!usart0_config.flow_control.rts_enabled || usart0_rts_paused) return;
+    if (usart_buffer_size(&usart0_rx_queue) < usart0_rts_high_water) return;
+
+    // Drive the level rather than toggling the pin, so that RTS always matches the flag
+    io_write(usart0_config.flow_control.rts_pin, IO_HIGH);
+    usart0_rts_paused = true;
+    usart0_stats_add(rx_throttled, 1);
+}
+
+/// @brief Assert RTS again if the RX buffer has been read down to its low-water mark. Called from
+///        the main loop after reading from the RX buffer.
+static inline void usart0_rts_resume(void) {
+    if (!usart0_rts_paused) return;
+    if (usart_buffer_size(&usart0_rx_queue) > usart0_rts_low_water) return;
+
+    // Write the pin and clear the flag, which hands RTS back to the RX interrupt, with interrupts
+    // disabled: the write is a read-modify-write of PORTx, which an interrupt that writes another
+    // pin of the port must not land in the middle of
+    uint8_t sreg = SREG;
+    cli();
+
+    io_write(usart0_config.flow_control.rts_pin, IO_LOW);
+    usart0_rts_paused = false;
+
+    SREG = sreg;
+}
+
 /// @brief Data register empty interrupt handler for USART0. Triggered when the USART0 data register
 ///        is empty and ready to receive more data.
 ISR(USART_UDRE_vect) {
-    if (!queue_is_empty(&usart0_tx_queue)) {
-        // Send the next byte in the TX buffer
-        char data;
-        queue_dequeue(&usart0_tx_queue, &data);
+    // Pause while CTS is deasserted, until its falling edge resumes transmission (see
+    // usart0_cts_resume())
+    if (usart0_cts_paused()) {
+        UCSR0B &= ~_BV(UDRIE0);
+        usart0_stats_add(tx_paused, 1);
+        return;
+    }
 
+    char data;
+    if (usart_echo_buffer_dequeue(&usart0_echo_queue, &data)) {
+        // Echoed bytes go first (see usart0_echo())
+        UDR0 = data;
+        usart0_stats_add(tx_bytes, 1);
+    } else if (usart_buffer_dequeue(&usart0_tx_queue, &data)) {
+        // Send the next byte in the TX buffer
         UDR0 = data;
+        usart0_stats_add(tx_bytes, 1);
     } else {
         // Nothing to send, disable data register empty interrupts
         UCSR0B &= ~_BV(UDRIE0);
+        sched_post_from_isr(SCHED_EVENT_USART0_TX_EMPTY);
+    }
+}
+
+/// @brief Echo a byte from the RX interrupt without waiting: write it to UDR0 directly if the
+///        transmitter can take it and nothing echoed is waiting, queue it for the UDRE interrupt
+///        otherwise, or drop it if the echo queue is full.
+static inline void usart0_echo(char c) {
+    if (usart_echo_buffer_is_empty(&usart0_echo_queue) && (UCSR0A & _BV(UDRE0)) &&
+        !usart0_cts_paused()) {
+        UDR0 = c;
+        usart0_stats_add(tx_bytes, 1);
+        return;
+    }
+
+    if (!usart_echo_buffer_enqueue(&usart0_echo_queue, c)) {
+        usart0_stats_add(echo_dropped, 1);
+        return;
+    }
+
+    UCSR0B |= _BV(UDRIE0);
+}
+
+/// @brief Start decoding a new frame.
+static inline void usart0_frame_restart(void) {
+    usart0_frame_decoder = (usart_frame_decoder){
+        .crc       = USART_FRAME_CRC_INIT,
+        .cobs_code = 0xFF,
+    };
+}
+
+/// @brief Stage a decoded byte of the current frame in the RX buffer, and add it to the CRC.
+static inline void usart0_frame_append(uint8_t byte) {
+    usart_frame_decoder *decoder = &usart0_frame_decoder;
+    if (decoder->invalid || decoder->dropped) return;
+
+    if (!usart_buffer_stage(&usart0_rx_queue, decoder->length, (char)byte)) {
+        decoder->dropped = true;
+        return;
+    }
+
+    decoder->length++;
+    decoder->crc = _crc_xmodem_update(decoder->crc, byte);
+}
+
+/// @brief Finish decoding the current frame at its delimiter, enqueuing it if it is valid.
+static inline void usart0_frame_end(void) {
+    usart_frame_decoder *decoder = &usart0_frame_decoder;
+
+    if (decoder->dropped) {
+        usart0_stats_add(rx_frames_dropped, 1);
+    } else if (decoder->length == 0 && !decoder->invalid) {
+        // Ignore empty frames (e.g. repeated delimiters)
+    } else if (decoder->invalid || decoder->length < 2 || decoder->crc != 0) {
+        usart0_stats_add(rx_frame_errors, 1);
+    } else if (usart_frame_queue_is_full(&usart0_frame_queue)) {
+        usart0_stats_add(rx_frames_dropped, 1);
+    } else {
+        // Publish the payload (leaving out the CRC) before its length, which the reader checks
+        // first
+        uint8_t length = decoder->length - 2;
+
+        usart_buffer_commit_write(&usart0_rx_queue, length);
+        usart_frame_queue_enqueue(&usart0_frame_queue, length);
+
+        usart0_stats_add(rx_frames, 1);
+        usart0_stats_max(rx_high_water, usart_buffer_size(&usart0_rx_queue));
+        sched_post_from_isr(SCHED_EVENT_USART0_FRAME);
+    }
+
+    usart0_frame_restart();
+}
+
+/// @brief Decode a received COBS byte.
+static inline void usart0_frame_receive_cobs(uint8_t byte) {
+    usart_frame_decoder *decoder = &usart0_frame_decoder;
+
+    if (byte == USART_COBS_DELIMITER) {
+        // A frame cannot end in the middle of a block
+        if (decoder->cobs_remaining > 0) decoder->invalid = true;
+
+        usart0_frame_end();
+    } else if (decoder->cobs_remaining > 0) {
+        usart0_frame_append(byte);
+        decoder->cobs_remaining--;
+    } else {
+        // A code byte starts a new block, so the previous block ended with its implied zero
+        if (decoder->cobs_code != 0xFF) usart0_frame_append(0x00);
+
+        decoder->cobs_code      = byte;
+        decoder->cobs_remaining = byte - 1;
+    }
+}
+
+/// @brief Decode a received SLIP byte.
+static inline void usart0_frame_receive_slip(uint8_t byte) {
+    usart_frame_decoder *decoder = &usart0_frame_decoder;
+
+    if (byte == USART_SLIP_END) {
+        // A frame cannot end with an escape
+        if (decoder->escaped) decoder->invalid = true;
+
+        usart0_frame_end();
+    } else if (decoder->escaped) {
+        decoder->escaped = false;
+
+        if (byte == USART_SLIP_ESC_END) {
+            usart0_frame_append(USART_SLIP_END);
+        } else if (byte == USART_SLIP_ESC_ESC) {
+            usart0_frame_append(USART_SLIP_ESC);
+        } else {
+            decoder->invalid = true;
+        }
+    } else if (byte == USART_SLIP_ESC) {
+        decoder->escaped = true;
+    } else {
+        usart0_frame_append(byte);
     }
 }
 
 /// @brief Receive complete interrupt handler for USART0.
 ISR(USART_RX_vect) {
-    // Read the byte from the data register
-    char data = UDR0;
+    // Read the status (which describes the byte in the data register), then the byte itself
+    uint8_t status = UCSR0A;
+    char data      = UDR0;
+
+    usart0_stats_add(rx_bytes, 1);
+    usart0_stats_add(rx_overrun_errors, (status & _BV(DOR0)) ? 1 : 0);
+    usart0_stats_add(rx_framing_errors, (status & _BV(FE0)) ? 1 : 0);
+    usart0_stats_add(rx_parity_errors, (status & _BV(UPE0)) ? 1 : 0);
+    (void)status;
+
+    // Decode frames into the RX buffer instead, if framing is enabled
+    if (usart0_config.framing != USART_FRAMING_NONE) {
+        // A byte received with a line error corrupts its frame
+        if (status & (_BV(FE0) | _BV(DOR0) | _BV(UPE0))) usart0_frame_decoder.invalid = true;
 
-    // Ignore the byte if the RX buffer is full
-    if (queue_is_full(&usart0_rx_queue)) return;
+        if (usart0_config.framing == USART_FRAMING_COBS) {
+            usart0_frame_receive_cobs((uint8_t)data);
+        } else {
+            usart0_frame_receive_slip((uint8_t)data);
+        }
+
+        usart0_rts_throttle();
+        return;
+    }
+
+    bool delimiter = usart0_config.rx_delimiter_enabled && data == usart0_config.rx_delimiter;
+
+    // Ignore the byte if the RX buffer is full. With a delimiter, its last free byte is kept for
+    // the delimiter: a line too long for the buffer is then cut short, rather than losing its
+    // delimiter and leaving usart_readline() waiting for a line that the full buffer can never
+    // complete.
+    uint8_t free = usart0_rx_queue.capacity - usart_buffer_size(&usart0_rx_queue);
+    if (free == 0 || (free == 1 && usart0_config.rx_delimiter_enabled && !delimiter)) {
+        usart0_stats_add(rx_dropped, 1);
+        return;
+    }
 
     // Echo the byte back to the sender if necessary
-    // (Convert carriage returns to newlines)
-    if (usart0_config.echo_on_recv) usart_write(BSP_USART0, (data == '\r') ? '\n' : data);
+    // (Send carriage returns and newlines as "\r\n", as usart_write() does for newlines)
+    if (usart0_config.echo_on_recv) {
+        if (data == '\r' || data == '\n') {
+            usart0_echo('\r');
+            usart0_echo('\n');
+        } else {
+            usart0_echo(data);
+        }
+    }
 
     // Enqueue the byte into the RX buffer
-    queue_enqueue(&usart0_rx_queue, &data);
+    usart_buffer_enqueue(&usart0_rx_queue, data);
+    usart0_rx_byte_count++;
+    usart0_stats_max(rx_high_water, usart_buffer_size(&usart0_rx_queue));
+    usart0_rts_throttle();
+    sched_post_from_isr(SCHED_EVENT_USART0_RX);
 
     // Call the callback function if there is one registered
-    if (usart0_callback) usart0_callback();
+    if (BSP_ISR_CALLBACKS && usart0_callback) usart0_callback();
+
+    // Complete the frame at the delimiter or the threshold (the length saturates, so that a long
+    // run of bytes without a delimiter cannot wrap it around to a threshold of 0)
+    uint8_t frame_length = usart0_rx_frame_length;
+    if (frame_length < UINT8_MAX) frame_length++;
+
+    if (delimiter) {
+        usart0_rx_lines_received++;
+        usart0_rx_frame_length = 0;
+        sched_post_from_isr(SCHED_EVENT_USART0_FRAME);
+
+        if (BSP_ISR_CALLBACKS && usart0_frame_callback) {
+            usart0_frame_callback(USART_RX_EVENT_DELIMITER, frame_length);
+        }
+    } else if (usart0_config.rx_threshold != 0 && frame_length == usart0_config.rx_threshold) {
+        usart0_rx_frame_length = 0;
+        sched_post_from_isr(SCHED_EVENT_USART0_FRAME);
+
+        if (BSP_ISR_CALLBACKS && usart0_frame_callback) {
+            usart0_frame_callback(USART_RX_EVENT_THRESHOLD, frame_length);
+        }
+    } else {
+        usart0_rx_frame_length = frame_length;
+    }
+}
+
+// TX helpers --------------------------------------------------------------------------------------
+
+/// @brief Discard up to count of the oldest bytes in the TX buffer.
+static void usart0_tx_discard(uint8_t count) {
+    // The UDRE interrupt is the TX buffer's only consumer, and we take its place. Masking UDRIE0
+    // is not enough, since the RX interrupt (echoing) and the CTS interrupt (resuming) set it
+    // again, so disable interrupts for the few instructions that this takes.
+    uint8_t sreg = SREG;
+    cli();
+
+    uint8_t size = usart_buffer_size(&usart0_tx_queue);
+    if (count > size) count = size;
+
+    usart_buffer_commit_read(&usart0_tx_queue, count);
+    usart0_stats_add(tx_dropped, count);
+
+    UCSR0B |= _BV(UDRIE0);
+
+    SREG = sreg;
+}
+
+/// @brief Enqueue bytes into the TX buffer, handling a full buffer according to the configured
+///        policy, and return the number of bytes enqueued.
+static size_t usart0_tx_push(const char *data, size_t len) {
+    // Without a TX buffer (a size of 0, for applications that never transmit) there is nowhere to
+    // put the data, and waiting for room would never end
+    if (usart0_tx_queue.capacity == 0) {
+        usart0_stats_add(tx_dropped, len);
+        return 0;
+    }
+
+    size_t written = 0;
+    uint32_t start = 0;
+    bool blocked   = false;
+
+    while (written < len) {
+        size_t remaining = len - written;
+        uint8_t chunk    = (remaining > UINT8_MAX) ? UINT8_MAX : (uint8_t)remaining;
+
+        written += usart_buffer_enqueue_n(&usart0_tx_queue, &data[written], chunk);
+        usart0_stats_max(tx_high_water, usart_buffer_size(&usart0_tx_queue));
+
+        // Enable TX interrupts, so that the buffer starts draining while we wait. (This
+        // read-modify-write needs no critical section: the interrupts only ever change UDRIE0,
+        // and whatever they did to it, it ends up set, as it should with bytes to send.)
+        UCSR0B |= _BV(UDRIE0);
+
+        if (written == len) break;
+
+        switch (usart0_config.tx_full_policy) {
+            case USART_FULL_POLICY_BLOCK:
+                // Count each write that has to wait once, not every wakeup
+                if (!blocked) usart0_stats_add(tx_blocked, 1);
+                blocked = true;
+
+                // Wait for the UDRE interrupt to make room
+                idle_wait_while(usart_buffer_is_full(&usart0_tx_queue));
+                break;
+            case USART_FULL_POLICY_DROP_NEW:
+                usart0_stats_add(tx_dropped, len - written);
+                return written;
+            case USART_FULL_POLICY_OVERWRITE_OLDEST:
+                remaining = len - written;
+                usart0_tx_discard((remaining > UINT8_MAX) ? UINT8_MAX : (uint8_t)remaining);
+                break;
+            case USART_FULL_POLICY_BLOCK_TIMEOUT:
+                if (!blocked) {
+                    usart0_stats_add(tx_blocked, 1);
+                    start = bsp_micros();
+                }
+                blocked = true;
+
+                if (bsp_micros() - start >= usart0_config.tx_timeout_us) {
+                    usart0_stats_add(tx_dropped, len - written);
+                    return written;
+                }
+
+                // As with USART_FULL_POLICY_BLOCK, but the clock's interrupt also wakes the CPU
+                // (at least every millisecond or so) to check the timeout
+                idle_wait_while(usart_buffer_is_full(&usart0_tx_queue));
+                break;
+        }
+    }
+
+    return written;
+}
+
+/// @brief Enqueue a character into the TX buffer, sending a carriage return before a newline (for
+///        terminals that require it), and return the number of bytes enqueued.
+static size_t usart0_tx_push_char(char c) {
+    if (c == '\n') return usart0_tx_push("\r\n", 2);
+
+    return usart0_tx_push(&c, 1);
+}
+
+/// @brief Enqueue text into the TX buffer, translating newlines like usart0_tx_push_char(), and
+///        return the number of bytes enqueued.
+static size_t usart0_tx_push_text(const char *text, size_t len) {
+    size_t written = 0;
+
+    while (len > 0) {
+        // Enqueue everything up to the next newline in bulk
+        const char *newline = memchr(text, '\n', len);
+        size_t segment      = newline ? (size_t)(newline - text) : len;
+        size_t pushed       = usart0_tx_push(text, segment);
+
+        written += pushed;
+        if (pushed < segment || !newline) break;
+
+        pushed = usart0_tx_push("\r\n", 2);
+
+        written += pushed;
+        if (pushed < 2) break;
+
+        text += segment + 1;
+        len -= segment + 1;
+    }
+
+    return written;
+}
+
+/// @brief Enqueue a byte into the TX buffer, and return true if it was enqueued.
+static bool usart0_tx_push_byte(uint8_t byte) {
+    char c = (char)byte;
+    return usart0_tx_push(&c, 1) == 1;
+}
+
+/// @brief Return byte i of a frame being sent.
+static inline uint8_t usart0_tx_frame_byte(const usart_tx_frame *frame, size_t i) {
+    return (i < frame->length) ? frame->payload[i] : frame->crc[i - frame->length];
+}
+
+/// @brief Enqueue bytes from up to (but not including) to of a frame being sent into the TX buffer
+///        as-is, and return true if they were all enqueued.
+static bool usart0_tx_push_frame_span(const usart_tx_frame *frame, size_t from, size_t to) {
+    // Enqueue the payload's part of the span in bulk, then the CRC's
+    if (from < frame->length) {
+        size_t end = (to < frame->length) ? to : frame->length;
+        if (usart0_tx_push((const char *)&frame->payload[from], end - from) < end - from) {
+            return false;
+        }
+
+        from = end;
+    }
+
+    size_t count = to - from;
+    return usart0_tx_push((const char *)&frame->crc[from - frame->length], count) == count;
+}
+
+/// @brief COBS-encode a frame into the TX buffer (without its delimiter), and return true if it was
+///        all enqueued.
+static bool usart0_tx_push_cobs(const usart_tx_frame *frame) {
+    size_t total = frame->length + sizeof(frame->crc);
+    size_t pos   = 0;
+
+    for (;;) {
+        // Each block is a code byte and the run of non-zero bytes that follows it, which is
+        // contiguous in the frame and can be enqueued in bulk
+        size_t run = 0;
+        while (pos + run < total && run < USART_COBS_MAX_RUN &&
+               usart0_tx_frame_byte(frame, pos + run) != 0) {
+            run++;
+        }
+
+        if (!usart0_tx_push_byte((uint8_t)(run + 1))) return false;
+        if (!usart0_tx_push_frame_span(frame, pos, pos + run)) return false;
+
+        pos += run;
+        if (pos == total) return true;
+
+        // Skip the zero that ended the block (implied by its code byte), unless the block ended
+        // because it was full
+        if (run < USART_COBS_MAX_RUN) pos++;
+    }
+}
+
+/// @brief SLIP-encode a frame into the TX buffer (without its delimiter), and return true if it was
+///        all enqueued.
+static bool usart0_tx_push_slip(const usart_tx_frame *frame) {
+    size_t total = frame->length + sizeof(frame->crc);
+    size_t pos   = 0;
+
+    while (pos < total) {
+        // Enqueue the run of bytes up to the next one that needs escaping in bulk
+        size_t run = 0;
+        while (pos + run < total) {
+            uint8_t byte = usart0_tx_frame_byte(frame, pos + run);
+            if (byte == USART_SLIP_END || byte == USART_SLIP_ESC) break;
+
+            run++;
+        }
+
+        if (!usart0_tx_push_frame_span(frame, pos, pos + run)) return false;
+
+        pos += run;
+        if (pos == total) break;
+
+        // Escape the byte that ended the run
+        char escape[2] = {(char)USART_SLIP_ESC, (char)USART_SLIP_ESC_ESC};
+        if (usart0_tx_frame_byte(frame, pos) == USART_SLIP_END) escape[1] = (char)USART_SLIP_ESC_END;
+
+        if (usart0_tx_push(escape, sizeof(escape)) < sizeof(escape)) return false;
+
+        pos++;
+    }
+
+    return true;
 }
 
 // Implementation ----------------------------------------------------------------------------------
@@ -86,12 +720,39 @@ void usart_init(usart device, usart_config config) {
 
     bsp_assert(!usart0_initialized, "USART0 has already been initialized.");
 
+    // Use the default buffers unless the application provided its own
+    if (!config.rx_buffer) {
+        config.rx_buffer      = USART0_RX_DEFAULT_STORAGE;
+        config.rx_buffer_size = USART0_RX_BUFFER_SIZE;
+    }
+
+    if (!config.tx_buffer) {
+        config.tx_buffer      = USART0_TX_DEFAULT_STORAGE;
+        config.tx_buffer_size = USART0_TX_BUFFER_SIZE;
+    }
+
+    bool rx_valid = usart_buffer_init(&usart0_rx_queue, config.rx_buffer, config.rx_buffer_size);
+    bool tx_valid = usart_buffer_init(&usart0_tx_queue, config.tx_buffer, config.tx_buffer_size);
+
+    bsp_assert(rx_valid, "USART0 RX buffer size must be a power of two (at most 128).");
+    bsp_assert(tx_valid, "USART0 TX buffer size must be a power of two (at most 128).");
+
     // Save the configuration
     usart0_config = config;
+    usart0_frame_restart();
 
     // Set the baud rate
-    UBRR0H = (uint8_t)UBRRH(config.baud_rate);
-    UBRR0L = (uint8_t)UBRRL(config.baud_rate);
+    usart0_baud = usart_baud_calculate(F_CPU, config.baud_rate);
+    bsp_assert(usart_baud_valid(usart0_baud), "USART0 baud rate is out of reach at this F_CPU.");
+
+    UBRR0H = (uint8_t)(usart0_baud.ubrr >> 8);
+    UBRR0L = (uint8_t)usart0_baud.ubrr;
+
+    if (usart0_baud.double_speed) {
+        UCSR0A |= _BV(U2X0);
+    } else {
+        UCSR0A &= ~_BV(U2X0);
+    }
 
     // Enable the receiver and transmitter blocks
     UCSR0B = _BV(RXEN0) | _BV(TXEN0);
@@ -105,79 +766,440 @@ void usart_init(usart device, usart_config config) {
 
     // Set the initialization flag
     usart0_initialized = true;
+
+    // Set up flow control from scratch
+    usart0_config.flow_control = (usart_flow_control){0};
+    usart_set_flow_control(device, config.flow_control);
 }
 
 bool usart_poll(usart device) {
     (void)device;
 
-    assert_usart0_initialized();
+    assert_usart0_initialized_debug();
 
     // Return true if there is data in the RX buffer
-    return !queue_is_empty(&usart0_rx_queue);
+    return !usart_buffer_is_empty(&usart0_rx_queue);
 }
 
 char usart_read(usart device) {
     (void)device;
 
+    assert_usart0_initialized_debug();
+
+    // Wait until there is data in the RX buffer, then dequeue it
+    char data;
+    while (!usart_buffer_dequeue(&usart0_rx_queue, &data)) {
+        idle_wait_while(usart_buffer_is_empty(&usart0_rx_queue));
+    }
+
+    usart0_rts_resume();
+    return data;
+}
+
+int16_t usart_read_timeout(usart device, uint16_t timeout_ms) {
+    (void)device;
+
     assert_usart0_initialized();
 
-    // Spin until there is data in the RX buffer
-    while (queue_is_empty(&usart0_rx_queue)) {}
+    uint32_t start = bsp_millis();
 
-    // Dequeue the byte from the RX buffer
+    // As usart_read(), but give up once the timeout has passed (the clock's interrupt wakes the
+    // CPU at least every millisecond or so to check)
     char data;
-    queue_dequeue(&usart0_rx_queue, &data);
+    while (!usart_buffer_dequeue(&usart0_rx_queue, &data)) {
+        if (bsp_millis() - start >= timeout_ms) return -1;
 
-    return data;
+        idle_wait_while(usart_buffer_is_empty(&usart0_rx_queue));
+    }
+
+    usart0_rts_resume();
+    return (uint8_t)data;
 }
 
 void usart_write(usart device, char c) {
     (void)device;
 
+    assert_usart0_initialized_debug();
+
+    usart0_tx_push_char(c);
+}
+
+size_t usart_read_buf(usart device, char *o_buf, size_t len) {
+    (void)device;
+
     assert_usart0_initialized();
 
-    if (c == '\n') {
-        // Send a carriage return before the newline (for terminals that require it)
-        usart_write(BSP_USART0, '\r');
+    size_t read = 0;
+
+    while (read < len) {
+        size_t remaining = len - read;
+        uint8_t chunk    = (remaining > UINT8_MAX) ? UINT8_MAX : (uint8_t)remaining;
+        uint8_t count    = usart_buffer_dequeue_n(&usart0_rx_queue, &o_buf[read], chunk);
+
+        read += count;
+        if (count < chunk) break;
     }
 
-    // Spin until there is space in the TX buffer
-    while (queue_is_full(&usart0_tx_queue)) {}
+    usart0_rts_resume();
+    return read;
+}
 
-    // Enqueue the byte in the TX buffer
-    queue_enqueue(&usart0_tx_queue, &c);
+int16_t usart_readline(usart device, char *o_buf, size_t len) {
+    (void)device;
 
-    // Enable TX interrupts
-    UCSR0B |= _BV(UDRIE0);
+    assert_usart0_initialized();
+
+    if (usart0_rx_lines_received == usart0_rx_lines_consumed) return -1;
+
+    // Copy the line up to its delimiter, leaving room for the NUL terminator
+    int16_t length = 0;
+    char data;
+
+    while (usart_buffer_dequeue(&usart0_rx_queue, &data)) {
+        if (data == usart0_config.rx_delimiter) break;
+
+        if ((size_t)length + 1 < len) o_buf[length++] = data;
+    }
+
+    if (len > 0) o_buf[length] = '\0';
+
+    usart0_rx_lines_consumed++;
+    usart0_rts_resume();
+    return length;
+}
+
+size_t usart_write_buf(usart device, const char *buf, size_t len) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    return usart0_tx_push(buf, len);
+}
+
+/// @brief Enqueue the output rendered into a chunk, and empty it.
+static void usart0_printf_flush(usart_printf_chunk *chunk) {
+    chunk->written += usart0_tx_push_text(chunk->data, chunk->length);
+    chunk->length = 0;
 }
 
 void _putchar(char c) {
-    usart_write(BSP_USART0, c);
+    assert_usart0_initialized_debug();
+
+    usart_printf_chunk *chunk = usart0_printf_chunk;
+
+    if (!chunk) {
+        usart0_tx_push_char(c);
+        return;
+    }
+
+    // A chunk with no room (see usart_vprintf_P()) enqueues each character directly
+    if (chunk->capacity == 0) {
+        chunk->written += usart0_tx_push_char(c);
+        return;
+    }
+
+    chunk->data[chunk->length++] = c;
+    if (chunk->length == chunk->capacity) usart0_printf_flush(chunk);
 }
 
-void usart_printf(usart device, const char* format, ...) {
-    (void)device;
+/// @brief Format output in a single pass, through _putchar(), into a buffer that is enqueued in
+///        bulk each time that it fills up, so that output of any length is only formatted once.
+static int usart0_vprintf(usart device,
+                          const char* format,
+                          va_list args,
+                          char *buffer,
+                          uint8_t capacity) {
+    bsp_assert(device == BSP_USART0, "Invalid USART device.");
 
     assert_usart0_initialized();
 
+    usart_printf_chunk chunk = {.data = buffer, .capacity = capacity};
+
+    usart_printf_chunk *outer = usart0_printf_chunk;
+    usart0_printf_chunk       = &chunk;
+
+    int length = vprintf(format, args);
+    usart0_printf_flush(&chunk);
+
+    usart0_printf_chunk = outer;
+
+    return (length < 0) ? length : (int)chunk.written;
+}
+
+int usart_printf(usart device, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = usart_vprintf(device, format, args);
+    va_end(args);
+
+    return written;
+}
+
+int usart_vprintf(usart device, const char* format, va_list args) {
+    char buffer[USART_PRINTF_BUFFER_SIZE];
+
+    return usart0_vprintf(device, format, args, buffer, sizeof(buffer));
+}
+
+int usart_printf_P(usart device, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    vprintf(format, args);
+    int written = usart_vprintf_P(device, format, args);
     va_end(args);
+
+    return written;
+}
+
+int usart_vprintf_P(usart device, const char* format, va_list args) {
+    // The formatter only reads formats from SRAM, so copy the format onto the stack for just this
+    // call, into the end of the buffer that the output is formatted into (which gets the rest)
+    char buffer[USART_PRINTF_BUFFER_SIZE];
+
+    // A truncated format could end in the middle of a conversion, leaving the arguments to be read
+    // against the wrong specifiers, so refuse it instead
+    size_t format_size = strlcpy_P(buffer, format, sizeof(buffer)) + 1;
+    if (format_size > sizeof(buffer)) return -1;
+
+    char *format_copy = memmove(&buffer[sizeof(buffer) - format_size], buffer, format_size);
+
+    return usart0_vprintf(device, format_copy, args, buffer, sizeof(buffer) - format_size);
 }
 
-void usart_vprintf(usart device, const char* format, va_list args) {
+usart_baud_setting usart_get_baud_setting(usart device) {
     (void)device;
 
     assert_usart0_initialized();
 
-    vprintf(format, args);
+    return usart0_baud;
+}
+
+usart_stats usart_get_stats(usart device) {
+    (void)device;
+
+    usart_stats stats = {0};
+
+#if BSP_USART_STATS
+    // The counters are updated by the USART interrupts and are wider than a byte; disable
+    // interrupts while copying them so that the snapshot is consistent. (Masking the USART
+    // interrupts in UCSR0B instead would take a read-modify-write that could undo an interrupt
+    // setting UDRIE0, see usart0_tx_discard().)
+    uint8_t sreg = SREG;
+    cli();
+
+    stats = usart0_stats;
+
+    SREG = sreg;
+#endif
+
+    return stats;
+}
+
+void usart_reset_stats(usart device) {
+    (void)device;
+
+#if BSP_USART_STATS
+    uint8_t sreg = SREG;
+    cli();
+
+    usart0_stats = (usart_stats){0};
+
+    SREG = sreg;
+#endif
+}
+
+void usart_set_echo(usart device, bool echo_on_recv) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    usart0_config.echo_on_recv = echo_on_recv;
+}
+
+void usart_set_tx_full_policy(usart device, usart_full_policy policy, uint32_t timeout_us) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    // Only writes (in the main loop) read the policy
+    usart0_config.tx_full_policy = policy;
+    usart0_config.tx_timeout_us  = timeout_us;
+}
+
+void usart_set_framing(usart device, usart_framing framing) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    // The RX interrupt is the only producer of the RX buffer and the frame queue; disable
+    // interrupts, and discard their contents in the consumer's place
+    uint8_t sreg = SREG;
+    cli();
+
+    usart_buffer_commit_read(&usart0_rx_queue, usart_buffer_size(&usart0_rx_queue));
+    usart_frame_queue_commit_read(&usart0_frame_queue, usart_frame_queue_size(&usart0_frame_queue));
+
+    usart0_rx_frame_length   = 0;
+    usart0_rx_lines_consumed = usart0_rx_lines_received;
+
+    usart0_frame_restart();
+    usart0_config.framing = framing;
+
+    SREG = sreg;
+
+    usart0_rts_resume();
+}
+
+bool usart_frame_poll(usart device) {
+    (void)device;
+
+    assert_usart0_initialized_debug();
+
+    return !usart_frame_queue_is_empty(&usart0_frame_queue);
+}
+
+int16_t usart_frame_read(usart device, void *o_buf, size_t len) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    uint8_t length;
+    if (!usart_frame_queue_peek(&usart0_frame_queue, &length)) return -1;
+
+    // Copy the payload, discarding what does not fit, then release its length
+    uint8_t count = (len < length) ? (uint8_t)len : length;
+
+    usart_buffer_dequeue_n(&usart0_rx_queue, o_buf, count);
+    usart_buffer_commit_read(&usart0_rx_queue, length - count);
+    usart_frame_queue_commit_read(&usart0_frame_queue, 1);
+
+    usart0_rts_resume();
+    return length;
+}
+
+bool usart_frame_write(usart device, const void *payload, size_t len) {
+    (void)device;
+
+    assert_usart0_initialized();
+    bsp_assert(usart0_config.framing != USART_FRAMING_NONE, "USART0 framing is not enabled.");
+
+    usart_tx_frame frame = {.payload = payload, .length = len};
+
+    uint16_t crc = USART_FRAME_CRC_INIT;
+    for (size_t i = 0; i < len; i++) crc = _crc_xmodem_update(crc, frame.payload[i]);
+
+    frame.crc[0] = (uint8_t)(crc >> 8);
+    frame.crc[1] = (uint8_t)crc;
+
+    bool cobs         = usart0_config.framing == USART_FRAMING_COBS;
+    uint8_t delimiter = cobs ? USART_COBS_DELIMITER : USART_SLIP_END;
+
+    // End whatever a frame that was cut short left on the line, so that the receiver discards it
+    // instead of this frame
+    bool complete = !usart0_tx_frame_broken || usart0_tx_push_byte(delimiter);
+
+    complete = complete && (cobs ? usart0_tx_push_cobs(&frame) : usart0_tx_push_slip(&frame));
+    complete = complete && usart0_tx_push_byte(delimiter);
+
+    usart0_tx_frame_broken = !complete;
+    return complete;
+}
+
+void usart_set_flow_control(usart device, usart_flow_control flow_control) {
+    (void)device;
+
+    assert_usart0_initialized();
+
+    if (flow_control.rts_enabled) {
+        uint8_t capacity = usart0_rx_queue.capacity;
+        if (flow_control.rts_high_water == 0) flow_control.rts_high_water = capacity - capacity / 4;
+
+        bsp_assert(flow_control.rts_high_water <= capacity,
+                   "USART0 RTS high-water mark must fit in the RX buffer.");
+    }
+
+    // The USART interrupts read the flow control configuration, and the RX and CTS interrupts set
+    // UDRIE0, so disable interrupts rather than masking them in UCSR0B (a read-modify-write that
+    // could undo UDRIE0 being set in the meantime, see usart0_tx_discard())
+    uint8_t sreg = SREG;
+    cli();
+
+    // Release the old pins, leaving RTS asserted
+    usart_flow_control *current = &usart0_config.flow_control;
+
+    if (current->rts_enabled) io_write(current->rts_pin, IO_LOW);
+    if (current->cts_enabled) io_event_unregister(current->cts_pin);
+
+    usart0_rts_paused = false;
+
+    if (flow_control.rts_enabled) {
+        usart0_rts_high_water = flow_control.rts_high_water;
+        usart0_rts_low_water  = flow_control.rts_high_water / 2;
+
+        io_configure(flow_control.rts_pin,
+                     (io_config){.direction = IO_DIRECTION_OUTPUT, .initial_level = IO_LOW});
+    }
+
+    if (flow_control.cts_enabled) {
+        io_configure(flow_control.cts_pin, (io_config){.direction = IO_DIRECTION_INPUT});
+        io_event_register(flow_control.cts_pin, IO_EDGE_FALLING, usart0_cts_resume);
+    }
+
+    usart0_config.flow_control = flow_control;
+
+    // Restart transmission, in case CTS had paused it
+    if (usart0_tx_pending()) UCSR0B |= _BV(UDRIE0);
+
+    SREG = sreg;
 }
 
 void usart_register_callback(usart device, usart_recv_callback on_character_recv) {
     (void)device;
 
     assert_usart0_initialized();
+    bsp_assert(BSP_ISR_CALLBACKS || !on_character_recv, "ISR callbacks are disabled.");
 
     usart0_callback = on_character_recv;
 }
+
+void usart_register_frame_callback(usart device, usart_frame_callback on_frame_recv) {
+    (void)device;
+
+    assert_usart0_initialized();
+    bsp_assert(BSP_ISR_CALLBACKS || !on_frame_recv, "ISR callbacks are disabled.");
+
+    usart0_frame_callback = on_frame_recv;
+}
+
+void usart_rx_tick(usart device) {
+    (void)device;
+
+    if (usart0_config.rx_idle_ticks == 0) return;
+
+    // Restart the idle gap whenever data has arrived since the last tick
+    uint8_t byte_count = usart0_rx_byte_count;
+    if (byte_count != usart0_rx_idle_last_count) {
+        usart0_rx_idle_last_count = byte_count;
+        usart0_rx_idle_ticks      = 0;
+        return;
+    }
+
+    if (usart0_rx_idle_ticks == usart0_config.rx_idle_ticks) return;
+    if (++usart0_rx_idle_ticks != usart0_config.rx_idle_ticks) return;
+
+    // The line just went idle; complete the partial frame, with interrupts disabled so that the RX
+    // interrupt (the frame length's other writer) cannot run in between
+    uint8_t sreg = SREG;
+    cli();
+
+    uint8_t frame_length   = usart0_rx_frame_length;
+    usart0_rx_frame_length = 0;
+
+    SREG = sreg;
+
+    if (frame_length == 0) return;
+
+    sched_post(SCHED_EVENT_USART0_FRAME);
+    if (BSP_ISR_CALLBACKS && usart0_frame_callback) {
+        usart0_frame_callback(USART_RX_EVENT_IDLE, frame_length);
+    }
+}
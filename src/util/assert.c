@@ -1,28 +1,130 @@
 #include "bsp/util/assert.h"
 
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <printf.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <util/delay.h>
 
 #include "bsp/io.h"
-#include "bsp/usart.h"
 
-void assert_handler(const char* file, int line, const char* msg_fmt, ...) {
-    // Print the file and line number.
-    usart_printf(BSP_USART0, "Assertion failed in %s on line %d: ", file, line);
+// Note:
+// A failed assert is reported by writing UDR0 directly, with interrupts disabled, rather than
+// through the USART driver. The driver's own functions assert that it is initialized, so an assert
+// that fails before or during usart_init() would otherwise report itself by failing again, until
+// the stack overflowed; writing UDR0 directly also works from interrupt handlers, which cannot wait
+// for the UDRE interrupt to drain the TX buffer. Nothing is printed unless usart_init() has enabled
+// the transmitter.
+
+// The size of the stack buffer that messages are formatted into; longer messages are cut off
+#define ASSERT_MESSAGE_BUFFER_SIZE 64
+
+/// @brief Send a character, waiting for the transmitter to take it.
+static void assert_putc(char c) {
+    while (!(UCSR0A & _BV(UDRE0))) {}
+    UDR0 = c;
+}
+
+/// @brief Print a string stored in SRAM.
+static void assert_print(const char* str) {
+    while (*str) assert_putc(*str++);
+}
+
+/// @brief Print a string stored in flash.
+static void assert_print_P(const char* str) {
+    char c;
+    while ((c = (char)pgm_read_byte(str++))) assert_putc(c);
+}
+
+/// @brief Format a message from a format in SRAM and print it.
+static void assert_vprintf(const char* format, va_list args) {
+    char buffer[ASSERT_MESSAGE_BUFFER_SIZE];
+    if (vsnprintf(buffer, sizeof(buffer), format, args) >= 0) assert_print(buffer);
+}
+
+/// @brief Format a message from a format in flash and print it. A format too long to be copied out
+///        of flash is printed as is, unformatted.
+static void assert_vprintf_P(const char* format, va_list args) {
+    char format_copy[ASSERT_MESSAGE_BUFFER_SIZE];
 
-    // Print the message.
+    if (strlcpy_P(format_copy, format, sizeof(format_copy)) >= sizeof(format_copy)) {
+        assert_print_P(format);
+        return;
+    }
+
+    assert_vprintf(format_copy, args);
+}
+
+/// @brief Like assert_vprintf_P(), with the arguments passed directly.
+static void assert_printf_P(const char* format, ...) {
     va_list args;
-    va_start(args, msg_fmt);
-    usart_vprintf(BSP_USART0, msg_fmt, args);
+    va_start(args, format);
+    assert_vprintf_P(format, args);
     va_end(args);
+}
 
-    // Print a newline.
-    usart_printf(BSP_USART0, "\r\n");
+/// @brief Disable interrupts, and return true if the message can be printed.
+static bool assert_begin(void) {
+    cli();
+
+    return UCSR0B & _BV(TXEN0);
+}
 
-    // Flash the debug LED forever.
+/// @brief Flash the debug LED forever.
+static void assert_halt(void) {
     io_configure(BSP_PB5, (io_config){.direction = IO_DIRECTION_OUTPUT});
     while (1) {
         io_toggle(BSP_PB5);
         _delay_ms(500);
     }
 }
+
+void assert_handler(const char* file, int line, const char* msg_fmt, ...) {
+    if (assert_begin()) {
+        // Print the file and line number.
+        assert_print_P(PSTR("Assertion failed in "));
+        assert_print(file);
+        assert_printf_P(PSTR(" on line %d: "), line);
+
+        // Print the message.
+        va_list args;
+        va_start(args, msg_fmt);
+        assert_vprintf(msg_fmt, args);
+        va_end(args);
+
+        // Print a newline.
+        assert_print_P(PSTR("\r\n"));
+    }
+
+    assert_halt();
+}
+
+void assert_handler_P(const char* file, int line, const char* msg_fmt, ...) {
+    if (assert_begin()) {
+        // Print the file and line number.
+        assert_print_P(PSTR("Assertion failed in "));
+        assert_print_P(file);
+        assert_printf_P(PSTR(" on line %d: "), line);
+
+        // Print the message.
+        va_list args;
+        va_start(args, msg_fmt);
+        assert_vprintf_P(msg_fmt, args);
+        va_end(args);
+
+        // Print a newline.
+        assert_print_P(PSTR("\r\n"));
+    }
+
+    assert_halt();
+}
+
+void assert_handler_id(uint8_t file_id, int line) {
+    if (assert_begin()) {
+        assert_printf_P(PSTR("Assertion failed in file %u on line %d\r\n"), file_id, line);
+    }
+
+    assert_halt();
+}
@@ -0,0 +1,138 @@
+#include "bsp/util/log.h"
+
+#include <avr/pgmspace.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "bsp/usart.h"
+
+// Timestamp source (initialized in log_set_timestamp_source())
+static log_timestamp_source log_timestamp = NULL;
+
+// Record encoding ---------------------------------------------------------------------------------
+
+typedef struct {
+    uint8_t data[LOG_RECORD_MAX_SIZE];
+    uint8_t size;
+} log_record;
+
+/// @brief Append bytes to a record, returning false (and appending nothing) if they do not fit.
+static bool log_record_append(log_record *record, const void *data, size_t size) {
+    if (size > (size_t)(LOG_RECORD_MAX_SIZE - record->size)) return false;
+
+    memcpy(&record->data[record->size], data, size);
+    record->size += (uint8_t)size;
+    return true;
+}
+
+/// @brief Append a string and its NUL terminator to a record, returning false if it does not fit.
+static bool log_record_append_string(log_record *record, const char *string) {
+    if (!string) string = "(null)";
+
+    return log_record_append(record, string, strlen(string) + 1);
+}
+
+// Implementation ----------------------------------------------------------------------------------
+
+void log_write_record(const char *format, ...) {
+    log_record record = {.size = 0};
+
+    uint16_t format_address = (uint16_t)(uintptr_t)format;
+    uint32_t timestamp      = log_timestamp ? log_timestamp() : 0;
+
+    // The sync byte and length come first; the length is filled in once the record is complete
+    record.data[0] = LOG_RECORD_SYNC;
+    record.size    = 2;
+    log_record_append(&record, &format_address, sizeof(format_address));
+    log_record_append(&record, &timestamp, sizeof(timestamp));
+
+    va_list args;
+    va_start(args, format);
+
+    // Walk the conversions in the format string (in flash) to find the type of each argument
+    bool fits = true;
+
+    for (const char *c = format; fits && pgm_read_byte(c); c++) {
+        if (pgm_read_byte(c) != '%') continue;
+
+        // Skip the flags, width and precision, encoding '*' widths and precisions (which are ints)
+        uint8_t length = 0;
+        char conversion;
+
+        while ((conversion = (char)pgm_read_byte(++c))) {
+            if (conversion == '*') {
+                int value = va_arg(args, int);
+                fits      = log_record_append(&record, &value, sizeof(value));
+            } else if (conversion == 'l') {
+                length++;
+            } else if (conversion == 'j') {
+                length = 2;
+            } else if (!strchr("-+ #0123456789.hzt", conversion)) {
+                break;
+            }
+        }
+
+        switch (conversion) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'b':
+                if (length >= 2) {
+                    long long value = va_arg(args, long long);
+                    fits            = log_record_append(&record, &value, sizeof(value));
+                } else if (length == 1) {
+                    long value = va_arg(args, long);
+                    fits       = log_record_append(&record, &value, sizeof(value));
+                } else {
+                    int value = va_arg(args, int);
+                    fits      = log_record_append(&record, &value, sizeof(value));
+                }
+                break;
+            case 'c': {
+                char value = (char)va_arg(args, int);
+                fits       = log_record_append(&record, &value, sizeof(value));
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double value = va_arg(args, double);
+                fits         = log_record_append(&record, &value, sizeof(value));
+                break;
+            }
+            case 'p': {
+                void *value = va_arg(args, void *);
+                fits        = log_record_append(&record, &value, sizeof(value));
+                break;
+            }
+            case 's':
+                fits = log_record_append_string(&record, va_arg(args, const char *));
+                break;
+            case '\0':
+                // The format string ended in the middle of a conversion
+                c--;
+                break;
+            default:
+                // "%%", or a conversion without an argument
+                break;
+        }
+    }
+
+    va_end(args);
+
+    // Send the record in one write
+    record.data[1] = record.size - 2;
+    usart_write_buf(BSP_USART0, (const char *)record.data, record.size);
+}
+
+void log_set_timestamp_source(log_timestamp_source source) {
+    log_timestamp = source;
+}
@@ -0,0 +1,61 @@
+#include "bsp/util/profile.h"
+
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bsp/usart.h"
+
+// The regions that have run, most recently added first
+static profile_region *profile_regions = NULL;
+
+void profile_record(profile_region *region, uint32_t cycles) {
+    // Add the region to the list on its first run
+    if (!region->listed) {
+        region->listed  = true;
+        region->next    = profile_regions;
+        profile_regions = region;
+    }
+
+    region->count++;
+    region->total += cycles;
+    if (cycles < region->min) region->min = cycles;
+    if (cycles > region->max) region->max = cycles;
+}
+
+void profile_dump(void) {
+    usart_printf_P(BSP_USART0,
+                   PSTR("%-16s %10s %10s %10s %10s %20s\n"),
+                   "region",
+                   "count",
+                   "min",
+                   "avg",
+                   "max",
+                   "total");
+
+    for (profile_region *region = profile_regions; region; region = region->next) {
+        char name[17];
+        strlcpy_P(name, region->name, sizeof(name));
+
+        uint32_t min     = region->count ? region->min : 0;
+        uint32_t average = region->count ? (uint32_t)(region->total / region->count) : 0;
+
+        usart_printf_P(BSP_USART0,
+                       PSTR("%-16s %10lu %10lu %10lu %10lu %20llu\n"),
+                       name,
+                       (unsigned long)region->count,
+                       (unsigned long)min,
+                       (unsigned long)average,
+                       (unsigned long)region->max,
+                       (unsigned long long)region->total);
+    }
+}
+
+void profile_reset(void) {
+    for (profile_region *region = profile_regions; region; region = region->next) {
+        region->count = 0;
+        region->min   = UINT32_MAX;
+        region->max   = 0;
+        region->total = 0;
+    }
+}
@@ -0,0 +1,1176 @@
+// Host tests for the BSP, run against the register simulator in sim/.
+//
+// Each test prints a line when it fails, and the executable exits with a non-zero status if any
+// did. Throughput is measured separately, by bench/bench.c.
+
+#define _XOPEN_SOURCE 700
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <util/twi.h>
+
+#include "bsp/clock.h"
+#include "bsp/debounce.h"
+#include "bsp/dsa/queue.h"
+#include "bsp/i2c.h"
+#include "bsp/idle.h"
+#include "bsp/io.h"
+#include "bsp/io_event.h"
+#include "bsp/sched.h"
+#include "bsp/sim.h"
+#include "bsp/spi.h"
+#include "bsp/usart.h"
+#include "bsp/util/assert.h"
+
+// The number of times that the tests which repeat an operation repeat it
+#define TEST_ITERATIONS 20000UL
+
+// The USART0 buffers, given to usart_init() so that the tests do not depend on the size of the
+// default buffers (the usart0_rx_buffer_size and usart0_tx_buffer_size meson options)
+#define TEST_USART_BUFFER_SIZE 16
+
+static char test_rx_buffer[TEST_USART_BUFFER_SIZE];
+static char test_tx_buffer[TEST_USART_BUFFER_SIZE];
+
+// Queue -------------------------------------------------------------------------------------------
+
+// An element wider than a byte, in a queue whose size is not a power of two, so that spans are
+// scaled by the element size and the indices wrap at an odd 2 * data_size
+typedef struct {
+    uint8_t bytes[3];
+} test_element;
+
+QUEUE_DECLARE_STATIC(test_wrap_queue, test_element, 5);
+
+// Check that reserve/commit spans stay within the storage and the free space as the indices wrap
+// around 2 * data_size many times, with every mix of span and commit sizes
+static bool test_queue_reserve_wrap(void) {
+    uint32_t produced = 0, consumed = 0, wraps = 0;
+    bool passed       = true;
+
+    for (uint32_t i = 0; i < 10000 && passed; i++) {
+        // Produce up to (i % 6) elements in place, in as many spans as it takes
+        for (size_t want = i % 6; want > 0;) {
+            size_t span;
+            test_element *dst = queue_reserve_write(&test_wrap_queue, &span);
+            if (span == 0) break;
+
+            passed &= span <= test_wrap_queue.data_size - queue_size(&test_wrap_queue);
+            passed &= dst + span <= (test_element *)test_wrap_queue.data + 5;
+
+            if (span > want) span = want;
+            for (size_t j = 0; j < span; j++, produced++) {
+                dst[j] = (test_element){{(uint8_t)produced, (uint8_t)~produced, 0xA5}};
+            }
+
+            uint8_t head_idx = test_wrap_queue.head_idx;
+            queue_commit_write(&test_wrap_queue, span);
+            wraps += test_wrap_queue.head_idx < head_idx;
+            want -= span;
+        }
+
+        // Consume up to (i % 4) + 1 elements in place
+        size_t span;
+        const test_element *src = queue_reserve_read(&test_wrap_queue, &span);
+
+        passed &= span <= queue_size(&test_wrap_queue);
+        passed &= src + span <= (const test_element *)test_wrap_queue.data + 5;
+
+        if (span > i % 4 + 1) span = i % 4 + 1;
+        for (size_t j = 0; j < span; j++, consumed++) {
+            passed &= src[j].bytes[0] == (uint8_t)consumed &&
+                      src[j].bytes[1] == (uint8_t)~consumed && src[j].bytes[2] == 0xA5;
+        }
+
+        queue_commit_read(&test_wrap_queue, span);
+        passed &= queue_size(&test_wrap_queue) == produced - consumed;
+    }
+
+    passed &= wraps > 100 && consumed > 10000;
+
+    if (!passed) printf("%-28s FAILED\n", "queue reserve/commit wrap");
+    return passed;
+}
+
+// SPSC stress -------------------------------------------------------------------------------------
+
+// Note:
+// A periodic SIGALRM stands in for an interrupt: it preempts the consumer at arbitrary points, just
+// like an ISR on the target, and the handler plays the producer by filling the queue with
+// consecutive sequence numbers. The consumer checks that it sees every number exactly once and in
+// order, and the test fails if it does not.
+
+#define STRESS_ITEMS       500000UL
+#define STRESS_INTERVAL_US 20
+
+// Deliberately not a power of two, so that the generic queue's index wrap-around is exercised
+QUEUE_DECLARE_STATIC(stress_queue, uint8_t, 7);
+
+QUEUE_TYPED_DEFINE(stress_typed_queue, uint8_t, 8);
+
+static stress_typed_queue stress_typed;
+
+// How the producer and the consumer access the queue
+typedef enum {
+    STRESS_GENERIC,
+    STRESS_GENERIC_RESERVE,
+    STRESS_TYPED,
+} stress_mode;
+
+static volatile stress_mode stress_current_mode;
+static volatile uint8_t stress_next_value;
+
+static void stress_isr(int signum) {
+    (void)signum;
+
+    if (stress_current_mode == STRESS_TYPED) {
+        while (stress_typed_queue_enqueue(&stress_typed, stress_next_value)) stress_next_value++;
+    } else if (stress_current_mode == STRESS_GENERIC_RESERVE) {
+        // Fill the free space in place, one contiguous span at a time
+        size_t span;
+        uint8_t *dst;
+
+        while ((dst = queue_reserve_write(&stress_queue, &span)) && span > 0) {
+            for (size_t i = 0; i < span; i++) dst[i] = stress_next_value++;
+            queue_commit_write(&stress_queue, span);
+        }
+    } else {
+        while (!queue_is_full(&stress_queue)) {
+            uint8_t value = stress_next_value;
+            queue_enqueue(&stress_queue, &value);
+            stress_next_value++;
+        }
+    }
+}
+
+static bool stress_consume(uint8_t *o_value) {
+    if (stress_current_mode == STRESS_TYPED) {
+        return stress_typed_queue_dequeue(&stress_typed, o_value);
+    }
+
+    if (stress_current_mode == STRESS_GENERIC_RESERVE) {
+        size_t span;
+        const uint8_t *src = queue_reserve_read(&stress_queue, &span);
+        if (span == 0) return false;
+
+        *o_value = src[0];
+        queue_commit_read(&stress_queue, 1);
+        return true;
+    }
+
+    if (queue_is_empty(&stress_queue)) return false;
+
+    queue_dequeue(&stress_queue, o_value);
+    return true;
+}
+
+static bool test_spsc_stress(const char *name, stress_mode mode) {
+    stress_current_mode = mode;
+    stress_next_value   = 0;
+
+    struct sigaction action = {.sa_handler = stress_isr};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+
+    struct itimerval timer = {
+        .it_interval = {.tv_usec = STRESS_INTERVAL_US},
+        .it_value    = {.tv_usec = STRESS_INTERVAL_US},
+    };
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    uint32_t errors = 0;
+
+    for (uint32_t consumed = 0; consumed < STRESS_ITEMS;) {
+        uint8_t value;
+        if (!stress_consume(&value)) continue;
+
+        if (value != (uint8_t)consumed) errors++;
+        consumed++;
+    }
+
+    setitimer(ITIMER_REAL, &(struct itimerval){0}, NULL);
+    signal(SIGALRM, SIG_DFL);
+
+    // Leave the queue empty for the next run
+    uint8_t value;
+    while (stress_consume(&value)) {}
+
+    if (errors) printf("%-28s FAILED: %lu out-of-order items\n", name, (unsigned long)errors);
+
+    return errors == 0;
+}
+
+// USART -------------------------------------------------------------------------------------------
+
+// Check the baud rate calculator against the datasheet's example UBRR settings. Where normal and
+// double speed mode are equally close (e.g. 9600 baud at 16 MHz), normal mode is expected.
+static bool test_usart_baud(void) {
+    static const struct {
+        uint32_t f_cpu, baud_rate;
+        uint16_t ubrr;
+        bool double_speed, valid;
+    } cases[] = {
+        {16000000UL, 9600, 103, false, true},
+        {16000000UL, 57600, 34, true, true},
+        {16000000UL, 115200, 16, true, true},
+        {16000000UL, 250000, 3, false, true},
+        {16000000UL, 1000000, 0, false, true},
+        {16000000UL, 2000000, 0, true, true},
+        {8000000UL, 38400, 12, false, true},
+        {8000000UL, 57600, 16, true, true},
+        {8000000UL, 250000, 1, false, true},
+        {1000000UL, 9600, 12, true, true},
+
+        // Out of reach: the closest settings are 3.5% (or more) off
+        {16000000UL, 230400, 8, true, false},
+        {8000000UL, 115200, 8, true, false},
+        {1000000UL, 115200, 0, true, false},
+        {16000000UL, 3000000, 0, true, false},
+    };
+
+    bool passed = true;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        usart_baud_setting setting = usart_baud_calculate(cases[i].f_cpu, cases[i].baud_rate);
+
+        bool matched = setting.ubrr == cases[i].ubrr &&
+                       setting.double_speed == cases[i].double_speed &&
+                       usart_baud_valid(setting) == cases[i].valid;
+
+        if (!matched) {
+            printf("%-28s FAILED: %lu baud at %lu Hz gave UBRR %u%s (%d)\n",
+                   "usart baud calculation",
+                   (unsigned long)cases[i].baud_rate,
+                   (unsigned long)cases[i].f_cpu,
+                   setting.ubrr,
+                   setting.double_speed ? " with U2X" : "",
+                   setting.error);
+        }
+
+        passed &= matched;
+    }
+
+    // A rate of 0 is never valid, and 115200 baud at 16 MHz is 2.1% fast
+    passed &= !usart_baud_valid(usart_baud_calculate(16000000UL, 0));
+    passed &= usart_baud_calculate(16000000UL, 115200).error == 212;
+
+    return passed;
+}
+
+static bool test_usart_stats_zero(usart_stats stats) {
+    return stats.rx_bytes == 0 && stats.tx_bytes == 0 && stats.rx_overrun_errors == 0 &&
+           stats.rx_framing_errors == 0 && stats.rx_parity_errors == 0 && stats.rx_dropped == 0 &&
+           stats.tx_dropped == 0 && stats.tx_blocked == 0 && stats.echo_dropped == 0 &&
+           stats.rx_frames == 0 && stats.rx_frame_errors == 0 && stats.rx_frames_dropped == 0 &&
+           stats.rx_throttled == 0 && stats.tx_paused == 0 && stats.rx_high_water == 0 &&
+           stats.tx_high_water == 0;
+}
+
+// Check the health counters against the events that they count. They are compiled out unless the
+// usart_stats meson option is on, in which case every counter reads as zero and this is skipped.
+static bool test_usart_stats(void) {
+    usart_reset_stats(BSP_USART0);
+    sim_usart0_receive('x');
+    usart_read(BSP_USART0);
+
+    if (usart_get_stats(BSP_USART0).rx_bytes == 0) {
+        printf("%-28s skipped (usart_stats is off)\n", "usart stats");
+        return true;
+    }
+
+    usart_reset_stats(BSP_USART0);
+
+    bool passed = test_usart_stats_zero(usart_get_stats(BSP_USART0));
+
+    // Line errors, reported by the hardware alongside each byte
+    sim_usart0_receive_with_errors('a', _BV(FE0));
+    sim_usart0_receive_with_errors('b', _BV(UPE0));
+    sim_usart0_receive_with_errors('c', _BV(DOR0));
+    sim_usart0_receive_with_errors('d', _BV(FE0) | _BV(UPE0));
+
+    // Bytes received into a full RX buffer (the delimiter takes the last byte, which is kept for it)
+    char buf[32];
+    usart_read_buf(BSP_USART0, buf, sizeof(buf));
+
+    for (uint8_t i = 0; i < 18; i++) sim_usart0_receive('e');
+    sim_usart0_receive('\n');
+    passed &= usart_readline(BSP_USART0, buf, sizeof(buf)) == 15;
+
+    usart_stats stats = usart_get_stats(BSP_USART0);
+    passed &= stats.rx_bytes == 4 + 19 && stats.rx_dropped == 3 && stats.rx_high_water == 16;
+    passed &= stats.rx_framing_errors == 2 && stats.rx_parity_errors == 2;
+    passed &= stats.rx_overrun_errors == 1;
+
+    // Writes that do not fit the (empty, 16-byte) TX buffer: the newest bytes are dropped, or the
+    // oldest are overwritten
+    static const char data[20] = "0123456789abcdefghij";
+    uint8_t out[32];
+
+    usart_reset_stats(BSP_USART0);
+    usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_DROP_NEW, 0);
+
+    passed &= usart_write_buf(BSP_USART0, data, sizeof(data)) == 16;
+    passed &= usart_get_stats(BSP_USART0).tx_dropped == 4;
+    passed &= sim_usart0_drain(out, sizeof(out)) == 16 && memcmp(out, data, 16) == 0;
+
+    usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_OVERWRITE_OLDEST, 0);
+
+    passed &= usart_write_buf(BSP_USART0, data, sizeof(data)) == sizeof(data);
+    passed &= usart_get_stats(BSP_USART0).tx_dropped == 8;
+    passed &= sim_usart0_drain(out, sizeof(out)) == 16 && memcmp(out, &data[4], 16) == 0;
+
+    usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_BLOCK, 0);
+
+    stats = usart_get_stats(BSP_USART0);
+    passed &= stats.tx_bytes == 32 && stats.tx_high_water == 16 && stats.tx_blocked == 0;
+
+    usart_reset_stats(BSP_USART0);
+    passed &= test_usart_stats_zero(usart_get_stats(BSP_USART0));
+
+    if (!passed) printf("%-28s FAILED\n", "usart stats");
+    return passed;
+}
+
+static uint32_t test_frame_events;
+static usart_rx_event test_frame_event;
+static uint8_t test_frame_length;
+
+static void test_frame_callback(usart_rx_event event, uint8_t length) {
+    test_frame_events++;
+    test_frame_event  = event;
+    test_frame_length = length;
+}
+
+// Check that a long run of bytes without a delimiter does not complete a frame when there is no
+// threshold (the frame length used to wrap around to 0 every 256 bytes), and that the delimiter
+// then completes it with a saturated length
+static bool test_usart_frame_events(void) {
+    usart_register_frame_callback(BSP_USART0, test_frame_callback);
+    test_frame_events = 0;
+
+    bool passed = true;
+    for (uint16_t i = 0; i < 300; i++) {
+        sched_pending = 0;
+        sim_usart0_receive('x');
+        passed &= !(sched_pending & SCHED_EVENT_USART0_FRAME);
+
+        char c;
+        usart_read_buf(BSP_USART0, &c, 1);
+    }
+
+    passed &= test_frame_events == 0;
+
+    sim_usart0_receive('\n');
+    passed &= test_frame_events == 1 && test_frame_event == USART_RX_EVENT_DELIMITER &&
+              test_frame_length == UINT8_MAX && (sched_pending & SCHED_EVENT_USART0_FRAME);
+
+    char line[4];
+    usart_readline(BSP_USART0, line, sizeof(line));
+
+    usart_register_frame_callback(BSP_USART0, NULL);
+    sched_pending = 0;
+
+    if (!passed) printf("%-28s FAILED\n", "usart frame events");
+    return passed;
+}
+
+// Check that a line too long for the RX buffer (of any size) is read cut short, and that the lines
+// after it are still read (its delimiter used to be dropped with the buffer full, so that no line
+// ever completed again)
+static bool test_usart_readline_overflow(void) {
+    char long_line[200], line[sizeof(long_line) + 1];
+    bool passed = true;
+
+    for (size_t i = 0; i < sizeof(long_line); i++) {
+        long_line[i] = (char)('a' + i % 26);
+        sim_usart0_receive((uint8_t)long_line[i]);
+    }
+    sim_usart0_receive('\n');
+
+    int16_t length = usart_readline(BSP_USART0, line, sizeof(line));
+    passed &= length > 0 && (size_t)length < sizeof(long_line) &&
+              strncmp(line, long_line, (size_t)length) == 0;
+
+    for (const char *c = "ok\n"; *c; c++) sim_usart0_receive((uint8_t)*c);
+    passed &= usart_readline(BSP_USART0, line, sizeof(line)) == 2 && strcmp(line, "ok") == 0;
+    passed &= !usart_poll(BSP_USART0);
+
+    if (!passed) printf("%-28s FAILED\n", "usart readline overflow");
+    return passed;
+}
+
+// The bytes sent while a write is blocked on the full TX buffer (see test_sleep_send())
+static uint8_t test_sent[256];
+static size_t test_sent_length;
+
+// A sleep that stands in for the transmitter draining a byte, and records it
+static void test_sleep_send(void) {
+    uint8_t byte;
+    if (sim_usart0_transmit(&byte) && test_sent_length < sizeof(test_sent)) {
+        test_sent[test_sent_length++] = byte;
+    }
+}
+
+// Check that output longer than the printf buffer (like a line of profile_dump()) is sent whole,
+// with its newline translated
+static bool test_usart_printf_long(void) {
+    char expected[128];
+    int length = snprintf(expected, sizeof(expected), "%-40s|%40d\r\n", "region", -7);
+
+    sim_set_sleep_hook(test_sleep_send);
+    test_sent_length = 0;
+    sei();
+
+    bool passed = usart_printf(BSP_USART0, "%-40s|%40d\n", "region", -7) == length;
+
+    cli();
+    sim_set_sleep_hook(NULL);
+
+    size_t capacity = sizeof(test_sent) - test_sent_length;
+    test_sent_length += sim_usart0_drain(&test_sent[test_sent_length], capacity);
+
+    passed &= length > USART_PRINTF_BUFFER_SIZE && test_sent_length == (size_t)length &&
+              memcmp(test_sent, expected, (size_t)length) == 0;
+
+    if (!passed) printf("%-28s FAILED\n", "usart_printf long output");
+    return passed;
+}
+
+// Check that a flash format too long for the stack copy is rejected instead of being cut off
+// (possibly in the middle of a conversion), and that one that fits is formatted
+static bool test_usart_printf_P_limit(void) {
+    char format[300];
+    memset(format, '.', sizeof(format));
+    memcpy(&format[sizeof(format) - 4], "%d\n", 4);
+
+    // Abort the test if the truncated format's output blocks on the full TX buffer
+    alarm(5);
+    bool passed = usart_printf_P(BSP_USART0, format, 1) < 0 && sim_usart0_drain(NULL, 0) == 0;
+    alarm(0);
+
+    uint8_t out[16];
+    passed &= usart_printf_P(BSP_USART0, PSTR("v=%d\n"), -7) == 6;
+    passed &= sim_usart0_drain(out, sizeof(out)) == 6 && memcmp(out, "v=-7\r\n", 6) == 0;
+
+    // The longest format accepted fills the whole buffer, leaving no room to format into: pad it
+    // with repeated '0' flags, which print nothing more
+    char longest[USART_PRINTF_BUFFER_SIZE];
+    memset(longest, '0', sizeof(longest));
+    longest[0] = '%';
+    memcpy(&longest[sizeof(longest) - 4], "5d\n", 4);
+
+    passed &= usart_printf_P(BSP_USART0, longest, 7) == 7;
+    passed &= sim_usart0_drain(out, sizeof(out)) == 7 && memcmp(out, "00007\r\n", 7) == 0;
+
+    if (!passed) printf("%-28s FAILED\n", "usart_printf_P format limit");
+    return passed;
+}
+
+// Echo --------------------------------------------------------------------------------------------
+
+#define ECHO_BURST 1000
+
+// Reproduce a pasted burst arriving on a console with echo enabled while the TX buffer is full and
+// the transmitter is stalled: the RX interrupt must neither wait for the TX buffer (which used to
+// hang forever, since the UDRE interrupt cannot run) nor lose the received bytes. Then check that
+// with the transmitter keeping up, every byte is echoed straight from the RX interrupt.
+static bool test_usart_echo(void) {
+    usart_set_echo(BSP_USART0, true);
+
+    // Abort the test (SIGALRM's default action) if the burst hangs
+    alarm(5);
+
+    char fill[TEST_USART_BUFFER_SIZE] = "0123456789abcdef";
+    usart_write_buf(BSP_USART0, fill, sizeof(fill));
+
+    uint32_t received = 0;
+    for (uint32_t i = 0; i < ECHO_BURST; i++) {
+        sim_usart0_receive((uint8_t)('a' + (i % 26)));
+
+        char c;
+        received += usart_read_buf(BSP_USART0, &c, 1);
+    }
+
+    alarm(0);
+
+    // The first echo goes straight to UDR0 and the next few wait in the echo queue, ahead of the
+    // TX buffer; the rest are dropped
+    uint8_t out[64];
+    size_t sent = sim_usart0_drain(out, sizeof(out));
+
+    bool passed = received == ECHO_BURST && sent == 1 + 4 + sizeof(fill) &&
+                  memcmp(out, "abcde0123456789abcdef", sent) == 0;
+
+    if (!passed) {
+        printf("%-28s FAILED: %lu received, %lu sent\n",
+               "usart echo burst",
+               (unsigned long)received,
+               (unsigned long)sent);
+    }
+
+    uint32_t echoed = 0;
+
+    for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+        sim_usart0_receive((uint8_t)('a' + (i & 15)));
+        echoed += sim_usart0_transmit(NULL);
+
+        char c;
+        usart_read_buf(BSP_USART0, &c, 1);
+    }
+
+    if (echoed != TEST_ITERATIONS) {
+        printf("%-28s FAILED: %lu of %lu bytes echoed\n",
+               "usart echo",
+               (unsigned long)echoed,
+               (unsigned long)TEST_ITERATIONS);
+    }
+
+    usart_set_echo(BSP_USART0, false);
+    return passed && echoed == TEST_ITERATIONS;
+}
+
+// Framing -----------------------------------------------------------------------------------------
+
+// A payload with bytes that both COBS and SLIP have to encode, short enough that its encoding fits
+// the TX buffer
+static const uint8_t test_frame_payload[8] = {0x01, 0x00, 0xC0, 0xDB, 0x55, 0x00, 0xAA, 0x7F};
+
+// Loop a frame back through the RX interrupt behind a corrupted copy of it, which must be rejected
+// without losing the frame that follows
+static bool test_usart_framing(const char *name, usart_framing framing) {
+    usart_set_framing(BSP_USART0, framing);
+    usart_frame_write(BSP_USART0, test_frame_payload, sizeof(test_frame_payload));
+
+    uint8_t encoded[32];
+    size_t encoded_length = sim_usart0_drain(encoded, sizeof(encoded));
+
+    for (size_t i = 0; i < encoded_length; i++) {
+        sim_usart0_receive((i == 3) ? encoded[i] ^ 0x10 : encoded[i]);
+    }
+
+    for (size_t i = 0; i < encoded_length; i++) sim_usart0_receive(encoded[i]);
+
+    uint8_t payload[16];
+    int16_t length = usart_frame_read(BSP_USART0, payload, sizeof(payload));
+
+    bool passed = length == sizeof(test_frame_payload) &&
+                  memcmp(payload, test_frame_payload, sizeof(test_frame_payload)) == 0 &&
+                  usart_frame_read(BSP_USART0, payload, sizeof(payload)) == -1;
+
+    if (!passed) printf("%-28s FAILED: read %d bytes\n", name, length);
+
+    usart_set_framing(BSP_USART0, USART_FRAMING_NONE);
+    return passed;
+}
+
+// Flow control ------------------------------------------------------------------------------------
+
+#define TEST_RTS_PIN BSP_PC0
+#define TEST_CTS_PIN BSP_PD3
+
+#define test_rts_deasserted() (PORTC & IO_PIN_MASK(TEST_RTS_PIN))
+#define test_set_cts(level)                                                                  \
+    sim_port_input(IO_PORT_D, (level) ? (PIND | IO_PIN_MASK(TEST_CTS_PIN))                   \
+                                      : (PIND & (uint8_t)~IO_PIN_MASK(TEST_CTS_PIN)))
+
+static bool test_usart_flow_control(void) {
+    usart_set_flow_control(BSP_USART0,
+                           (usart_flow_control){
+                               .rts_enabled    = true,
+                               .rts_pin        = TEST_RTS_PIN,
+                               .rts_high_water = 8,
+                               .cts_enabled    = true,
+                               .cts_pin        = TEST_CTS_PIN,
+                           });
+    test_set_cts(IO_LOW);
+
+    // A sender that honours RTS (sending two bytes per check, so that it overshoots the mark)
+    // streams twice as fast as the application reads, in bursts, from the 16-byte RX buffer;
+    // without flow control, most of the stream would be dropped
+    uint8_t next_sent     = 0;
+    uint8_t next_received = 0;
+    uint64_t bytes        = 0;
+    bool in_order         = true;
+
+    for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+        if (!test_rts_deasserted()) {
+            sim_usart0_receive(next_sent++);
+            sim_usart0_receive(next_sent++);
+        }
+
+        if (i % 8 != 7) continue;
+
+        char burst[8];
+        size_t count = usart_read_buf(BSP_USART0, burst, sizeof(burst));
+
+        for (size_t j = 0; j < count; j++) in_order &= (uint8_t)burst[j] == next_received++;
+        bytes += count;
+    }
+
+    char rest[16];
+    usart_read_buf(BSP_USART0, rest, sizeof(rest));
+
+    // RTS follows the RX buffer level even if something else has written the pin while it was
+    // deasserted (it used to be toggled, which then left it inverted for good)
+    for (uint8_t i = 0; i < 8; i++) sim_usart0_receive(i);
+
+    bool rts_levels = test_rts_deasserted();
+    io_write(TEST_RTS_PIN, IO_LOW);
+    usart_read_buf(BSP_USART0, rest, sizeof(rest));
+
+    rts_levels &= !test_rts_deasserted();
+    for (uint8_t i = 0; i < 8; i++) sim_usart0_receive(i);
+    rts_levels &= test_rts_deasserted();
+    usart_read_buf(BSP_USART0, rest, sizeof(rest));
+    rts_levels &= !test_rts_deasserted();
+
+    // Transmission pauses while CTS is deasserted, and resumes on its falling edge
+    test_set_cts(IO_HIGH);
+    usart_write_buf(BSP_USART0, "abcd", 4);
+
+    size_t sent_paused = sim_usart0_drain(NULL, 0);
+
+    test_set_cts(IO_LOW);
+
+    size_t sent_resumed = sim_usart0_drain(NULL, 0);
+
+    usart_set_flow_control(BSP_USART0, (usart_flow_control){0});
+
+    bool passed = in_order && bytes > TEST_ITERATIONS / 2 && rts_levels && sent_paused == 0 &&
+                  sent_resumed == 4;
+    if (!passed) {
+        printf("%-28s FAILED: %s, %s, %llu bytes, %lu sent paused, %lu resumed\n",
+               "usart flow control",
+               in_order ? "in order" : "out of order",
+               rts_levels ? "RTS levels right" : "RTS levels wrong",
+               (unsigned long long)bytes,
+               (unsigned long)sent_paused,
+               (unsigned long)sent_resumed);
+    }
+
+    return passed;
+}
+
+// SPI ---------------------------------------------------------------------------------------------
+
+#define TEST_SPI_CS_PIN BSP_PC1
+
+#define test_spi_deselected() ((PORTC & IO_PIN_MASK(TEST_SPI_CS_PIN)) ? 1U : 0U)
+
+static uint32_t test_spi_completions;
+
+// The chip select level seen by each completion callback (bit n for the nth). The next queued
+// transfer has already selected the device again by the time that the callback runs.
+static uint32_t test_spi_cs_levels;
+
+static void test_spi_complete(spi_transfer *transfer) {
+    (void)transfer;
+
+    test_spi_cs_levels |= test_spi_deselected() << test_spi_completions;
+    test_spi_completions++;
+}
+
+static void test_spi_sleep(void) {
+    sim_spi_run(NULL, NULL, 0);
+}
+
+static bool test_spi(void) {
+    spi_init((spi_config){.clock = SPI_CLOCK_DIV_2, .mode = SPI_MODE_0});
+    io_configure(TEST_SPI_CS_PIN,
+                 (io_config){.direction = IO_DIRECTION_OUTPUT, .initial_level = IO_HIGH});
+
+    // A command whose response is read with the device kept selected, then a write that receives
+    // nothing, queued to run back to back
+    static const uint8_t command[2] = {0x03, 0x10};
+    static const uint8_t data[3]    = {0xA1, 0xA2, 0xA3};
+    uint8_t response[4]             = {0};
+
+    spi_transfer transfers[3] = {
+        {.cs_pin = TEST_SPI_CS_PIN, .cs_hold = true, .tx_buf = command, .length = 2},
+        {.cs_pin = TEST_SPI_CS_PIN, .rx_buf = response, .length = 4},
+        {.cs_pin = TEST_SPI_CS_PIN, .tx_buf = data, .length = 3},
+    };
+
+    static const uint8_t miso[9]          = {0x00, 0x00, 0xB1, 0xB2, 0xB3, 0xB4, 0x00, 0x00, 0x00};
+    static const uint8_t expected_mosi[9] = {0x03, 0x10, 0xFF, 0xFF, 0xFF, 0xFF, 0xA1, 0xA2, 0xA3};
+    uint8_t mosi[9];
+    size_t exchanged = 0;
+
+    // Whenever the queue (of spi_queue_size transfers) is full, run the bus to make room
+    bool passed = true;
+    for (uint8_t i = 0; i < 3 && passed; i++) {
+        transfers[i].on_complete = test_spi_complete;
+
+        while (passed && !spi_submit(&transfers[i])) {
+            size_t count = sim_spi_run(&miso[exchanged], &mosi[exchanged], sizeof(mosi) - exchanged);
+
+            exchanged += count;
+            passed &= count > 0;
+        }
+    }
+
+    // The second transfer's callback sees the device selected again if the third was queued by
+    // then (and so started first)
+    uint32_t expected_cs_levels = (test_spi_completions < 2) ? 0x04 : 0x06;
+
+    passed &= !test_spi_deselected() && spi_busy();
+    exchanged += sim_spi_run(&miso[exchanged], &mosi[exchanged], sizeof(mosi) - exchanged);
+    passed &= exchanged == sizeof(mosi) && memcmp(mosi, expected_mosi, sizeof(mosi)) == 0;
+    passed &= memcmp(response, &miso[2], sizeof(response)) == 0;
+    passed &= test_spi_completions == 3 && test_spi_cs_levels == expected_cs_levels;
+    passed &= transfers[2].status == SPI_STATUS_DONE && !spi_busy() && test_spi_deselected();
+
+    // The blocking wrapper sleeps until the (simulated) SPI interrupt completes the transfer
+    spi_transfer blocking = {.cs_pin = TEST_SPI_CS_PIN, .tx_buf = data, .length = sizeof(data)};
+
+    sim_set_sleep_hook(test_spi_sleep);
+    sei();
+    spi_transfer_blocking(&blocking);
+    cli();
+    sim_set_sleep_hook(NULL);
+
+    passed &= blocking.status == SPI_STATUS_DONE;
+
+    // A chip select that was left low (it used to be toggled, which then left it inverted) is
+    // released after the transfer
+    io_write(TEST_SPI_CS_PIN, IO_LOW);
+    passed &= spi_submit(&transfers[2]) && sim_spi_run(NULL, NULL, 0) == sizeof(data);
+    passed &= test_spi_deselected();
+
+    if (!passed) printf("%-28s FAILED\n", "spi transfers");
+    return passed;
+}
+
+// I2C ---------------------------------------------------------------------------------------------
+
+#define TEST_I2C_ADDRESS 0x50
+
+// The registers of the simulated device
+static uint8_t test_i2c_memory[16];
+
+static uint32_t test_i2c_completions;
+
+// Whether the next transaction's START had been requested when each completion callback ran (bit n
+// for the nth)
+static uint32_t test_i2c_started;
+
+static void test_i2c_complete(i2c_transaction *transaction) {
+    (void)transaction;
+
+    test_i2c_started |= ((TWCR & _BV(TWSTA)) ? 1UL : 0UL) << test_i2c_completions;
+    test_i2c_completions++;
+}
+
+static void test_i2c_sleep(void) {
+    sim_twi_run();
+}
+
+static bool test_i2c(void) {
+    i2c_init((i2c_config){.frequency = I2C_FREQUENCY_FAST});
+    sim_twi_attach(TEST_I2C_ADDRESS, test_i2c_memory, sizeof(test_i2c_memory));
+
+    // 400 kHz at 16 MHz: 16 + 2 * 12 = 40 cycles per bit, with a prescaler of 1
+    bool passed = TWBR == 12 && (TWSR & (_BV(TWPS1) | _BV(TWPS0))) == 0;
+
+    // A write, a register read (a write of the register address followed by a read after a
+    // repeated start), a read that continues from there and a write to a missing device, queued to
+    // run back to back
+    static const uint8_t write[4]   = {0x02, 0x11, 0x22, 0x33};
+    static const uint8_t pointer[1] = {0x02};
+    uint8_t read[3]                 = {0};
+    uint8_t next[2]                 = {0};
+
+    test_i2c_memory[5] = 0x55;
+    test_i2c_memory[6] = 0x66;
+
+    i2c_transaction transactions[4] = {
+        {.address = TEST_I2C_ADDRESS, .tx_buf = write, .tx_length = sizeof(write)},
+        {
+            .address   = TEST_I2C_ADDRESS,
+            .tx_buf    = pointer,
+            .tx_length = sizeof(pointer),
+            .rx_buf    = read,
+            .rx_length = sizeof(read),
+        },
+        {.address = TEST_I2C_ADDRESS, .rx_buf = next, .rx_length = sizeof(next)},
+        {.address = TEST_I2C_ADDRESS + 1, .tx_buf = write, .tx_length = sizeof(write)},
+    };
+
+    // Whenever the queue (of i2c_queue_size transactions) is full, run the bus to make room. Each
+    // transaction's callback sees the next one started if it was queued by then.
+    uint32_t expected_started = 0;
+
+    for (uint8_t i = 0; i < 4 && passed; i++) {
+        transactions[i].on_complete = test_i2c_complete;
+
+        while (passed && !i2c_submit(&transactions[i])) passed &= sim_twi_run() > 0;
+
+        if (i > 0 && test_i2c_completions < i) expected_started |= 1UL << (i - 1);
+    }
+
+    static const uint8_t expected_next[2] = {0x55, 0x66};
+
+    passed &= i2c_busy();
+    passed &= sim_twi_run() > 0 && !i2c_busy() && test_i2c_completions == 4;
+    passed &= test_i2c_started == expected_started;
+    passed &= memcmp(&test_i2c_memory[2], &write[1], 3) == 0;
+    passed &= memcmp(read, &write[1], sizeof(read)) == 0;
+    passed &= memcmp(next, expected_next, sizeof(next)) == 0;
+    passed &= transactions[2].status == I2C_STATUS_DONE;
+    passed &= transactions[3].status == I2C_STATUS_ADDRESS_NACK;
+
+    // The blocking wrapper sleeps until the (simulated) TWI interrupt ends the transaction, which
+    // the device cuts short by not acknowledging a byte past the end of its registers
+    static const uint8_t overflow[3] = {0x0F, 0xAA, 0xBB};
+    i2c_transaction blocking = {
+        .address   = TEST_I2C_ADDRESS,
+        .tx_buf    = overflow,
+        .tx_length = sizeof(overflow),
+    };
+
+    sim_set_sleep_hook(test_i2c_sleep);
+    sei();
+    passed &= i2c_transfer_blocking(&blocking) == I2C_STATUS_DATA_NACK;
+    cli();
+    sim_set_sleep_hook(NULL);
+
+    i2c_stats stats = i2c_get_stats();
+
+    passed &= test_i2c_memory[15] == 0xAA;
+    passed &= stats.transactions == 3 && stats.address_nacks == 1 && stats.data_nacks == 1;
+    passed &= stats.arbitration_lost == 0 && stats.bus_errors == 0;
+
+    // A bus error while the bus is idle (with no transaction to end) is counted, and the TWI
+    // recovered for the next transaction
+    TWSR = (TWSR & (_BV(TWPS1) | _BV(TWPS0))) | TW_BUS_ERROR;
+    sim_isr_twi();
+    sim_twi_run();
+
+    passed &= !i2c_busy() && i2c_get_stats().bus_errors == 1;
+    passed &= i2c_submit(&transactions[0]) && sim_twi_run() > 0;
+    passed &= transactions[0].status == I2C_STATUS_DONE;
+
+    if (!passed) printf("%-28s FAILED\n", "i2c transactions");
+    return passed;
+}
+
+// Blocking waits --------------------------------------------------------------------------------
+
+static uint32_t test_sleeps;
+
+// Each sleep stands in for the interrupt that wakes the CPU: a received byte, the transmitter
+// draining a byte, or a millisecond passing
+static void test_sleep_receive(void) {
+    test_sleeps++;
+    sim_usart0_receive('x');
+}
+
+static void test_sleep_transmit(void) {
+    test_sleeps++;
+    sim_usart0_transmit(NULL);
+}
+
+static void test_sleep_millisecond(void) {
+    test_sleeps++;
+    sim_advance_cycles(F_CPU / 1000);
+}
+
+// Check that blocked reads and writes sleep until the interrupt they wait for, and that
+// usart_read_timeout() and writes with USART_FULL_POLICY_BLOCK_TIMEOUT give up
+static bool test_usart_blocking(void) {
+    bool passed = true;
+    sei();
+
+    sim_set_sleep_hook(test_sleep_receive);
+    test_sleeps = 0;
+
+    char c = 0;
+    for (uint32_t i = 0; i < TEST_ITERATIONS; i++) c |= (char)usart_read(BSP_USART0);
+    passed &= test_sleeps == TEST_ITERATIONS && c == 'x';
+
+    // Size the TX buffer by filling it with the transmitter stalled, dropping what does not fit
+    char fill[UINT8_MAX + 1];
+    memset(fill, '.', sizeof(fill));
+
+    usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_DROP_NEW, 0);
+    size_t tx_capacity = usart_write_buf(BSP_USART0, fill, sizeof(fill));
+    sim_usart0_drain(NULL, 0);
+    usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_BLOCK, 0);
+
+    // Without a TX buffer, writes drop their data instead of waiting, so there is nothing to check
+    if (tx_capacity == 0) {
+        printf("%-28s skipped (no TX buffer)\n", "usart blocking writes");
+    } else {
+        // Fill the TX buffer, then write one more byte than fits
+        sim_set_sleep_hook(test_sleep_transmit);
+        test_sleeps = 0;
+
+        usart_write_buf(BSP_USART0, fill, tx_capacity + 1);
+        passed &= test_sleeps == 1;
+        sim_usart0_drain(NULL, 0);
+
+        // With the transmitter stalled, a write that does not fit sleeps until its timeout has
+        // passed and drops the rest
+        sim_set_sleep_hook(test_sleep_millisecond);
+        usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_BLOCK_TIMEOUT, 5000);
+        test_sleeps = 0;
+
+        passed &= usart_write_buf(BSP_USART0, fill, tx_capacity + 1) == tx_capacity;
+        passed &= test_sleeps >= 5 && test_sleeps <= 6;
+        sim_usart0_drain(NULL, 0);
+
+        usart_set_tx_full_policy(BSP_USART0, USART_FULL_POLICY_BLOCK, 0);
+    }
+
+    sim_set_sleep_hook(test_sleep_millisecond);
+    test_sleeps = 0;
+
+    passed &= usart_read_timeout(BSP_USART0, 5) == -1 && test_sleeps >= 5 && test_sleeps <= 6;
+
+    sim_set_sleep_hook(NULL);
+    cli();
+
+    if (!passed) printf("%-28s FAILED\n", "usart blocking waits");
+    return passed;
+}
+
+// Scheduler ---------------------------------------------------------------------------------------
+
+static uint32_t test_sched_rx_bytes, test_sched_user_runs;
+
+static void test_sched_rx_task(sched_events events) {
+    (void)events;
+
+    char buf[16];
+    test_sched_rx_bytes += usart_read_buf(BSP_USART0, buf, sizeof(buf));
+}
+
+static void test_sched_user_task(sched_events events) {
+    (void)events;
+
+    test_sched_user_runs++;
+}
+
+// Check that each task only runs for its own events, and that an event posted twice before the
+// scheduler runs only runs its task once
+static bool test_sched(void) {
+    static const sched_task tasks[] = {
+        {.events = SCHED_EVENT_USART0_RX, .run = test_sched_rx_task},
+        {.events = SCHED_EVENT_USER(0), .run = test_sched_user_task},
+    };
+
+    sched_init(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    sched_run_once();
+
+    test_sched_rx_bytes = test_sched_user_runs = 0;
+
+    for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+        sim_usart0_receive((uint8_t)('a' + (i & 15)));
+        sched_run_once();
+    }
+
+    sched_post(SCHED_EVENT_USER(0));
+    sched_post(SCHED_EVENT_USER(0));
+    sched_run_once();
+
+    bool passed = test_sched_rx_bytes == TEST_ITERATIONS && test_sched_user_runs == 1 &&
+                  !sched_run_once();
+
+    if (!passed) printf("%-28s FAILED\n", "sched");
+    return passed;
+}
+
+// IO events ---------------------------------------------------------------------------------------
+
+static volatile uint32_t test_io_events;
+
+static void test_io_event_callback(io_pin pin, io_logic_level level) {
+    (void)pin;
+    (void)level;
+
+    test_io_events++;
+}
+
+// Check that exactly the registered edges are reported, for an external interrupt pin and a pin
+// change interrupt pin (with another watched pin on the same port)
+static bool test_io_event(const char *name, io_pin pin, io_edge edge) {
+    uint8_t port = IO_PORT_IDX(pin);
+    uint8_t mask = IO_PIN_MASK(pin);
+
+    // Start low, so that every iteration below is an edge (alternately rising and falling)
+    io_configure(pin, (io_config){.direction = IO_DIRECTION_INPUT});
+    sim_port_input(port, 0);
+    io_event_register(pin, edge, test_io_event_callback);
+
+    test_io_events = 0;
+
+    for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+        sim_port_input(port, (i & 1) ? 0 : mask);
+    }
+
+    io_event_unregister(pin);
+
+    uint32_t expected = (edge == IO_EDGE_BOTH) ? TEST_ITERATIONS : TEST_ITERATIONS / 2;
+
+    if (test_io_events != expected) {
+        printf("%-28s FAILED: %lu events, expected %lu\n",
+               name,
+               (unsigned long)test_io_events,
+               (unsigned long)expected);
+    }
+
+    return test_io_events == expected;
+}
+
+// Check that watching another pin of a port does not lose an edge on an already watched pin that
+// is waiting for the pin change interrupt
+static bool test_io_event_pending(void) {
+    sim_port_input(0, 0);
+    io_event_register(BSP_PB0, IO_EDGE_BOTH, test_io_event_callback);
+    test_io_events = 0;
+
+    // PB0 rises, but its interrupt has not run yet when PB1 is registered
+    PINB = IO_PIN_MASK(BSP_PB0);
+    io_event_register(BSP_PB1, IO_EDGE_BOTH, test_io_event_callback);
+    sim_isr_pcint0();
+
+    bool passed = test_io_events == 1;
+
+    io_event_unregister(BSP_PB1);
+    io_event_unregister(BSP_PB0);
+    sim_port_input(0, 0);
+
+    if (!passed) printf("%-28s FAILED\n", "pending pin change edge");
+    return passed;
+}
+
+// Debounce ----------------------------------------------------------------------------------------
+
+// Check that a bouncing input changes the debounced level exactly once, and that glitches shorter
+// than DEBOUNCE_TICKS are ignored
+static bool test_debounce_check(void) {
+    static const uint8_t bounce[] = {1, 0, 1, 1, 0, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1};
+
+    uint8_t rising = 0, falling = 0;
+
+    for (size_t i = 0; i < sizeof(bounce); i++) {
+        sim_port_input(IO_PORT_C, bounce[i] ? 0x01 : 0x00);
+        sim_timer2_compare_a();
+
+        rising += debounce_rose(BSP_PC0);
+        falling += debounce_fell(BSP_PC0);
+    }
+
+    bool passed = rising == 1 && falling == 0 && debounce_read(BSP_PC0) == IO_HIGH;
+
+    if (!passed) {
+        printf("%-28s FAILED: %u rising, %u falling edges\n", "debounce", rising, falling);
+    }
+
+    sim_port_input(IO_PORT_C, 0);
+    return passed;
+}
+
+// Clock -------------------------------------------------------------------------------------------
+
+// Check the clocks against a simulated 3 s (plus a partial Timer0 and Timer1 period), advanced in
+// uneven steps
+static bool test_clock_check(void) {
+    clock_init();
+
+    uint32_t cycles = 3 * F_CPU + 1000;
+    for (uint32_t advanced = 0; advanced < cycles; advanced += 997) {
+        sim_advance_cycles((cycles - advanced < 997) ? cycles - advanced : 997);
+    }
+
+    uint32_t expected_us = cycles / (F_CPU / 1000000UL);
+    uint32_t millis = bsp_millis(), micros = bsp_micros(), counted = bsp_cycles();
+
+    // bsp_micros() has a resolution of one Timer0 tick, and bsp_millis() lags it by less than a
+    // Timer0 period
+    bool passed = counted == cycles && micros <= expected_us && expected_us - micros < 64 &&
+                  millis <= micros / 1000 && micros / 1000 - millis <= 2;
+
+    // Reading the clocks leaves the overflow interrupts as they were (they used to be turned on)
+    TIMSK0 &= (uint8_t)~_BV(TOIE0);
+    TIMSK1 &= (uint8_t)~_BV(TOIE1);
+    passed &= bsp_millis() == millis && bsp_micros() == micros && bsp_cycles() == counted;
+    passed &= !(TIMSK0 & _BV(TOIE0)) && !(TIMSK1 & _BV(TOIE1));
+    TIMSK0 |= _BV(TOIE0);
+    TIMSK1 |= _BV(TOIE1);
+
+    if (!passed) {
+        printf("%-28s FAILED: %lu ms, %lu us, %lu cycles after %lu cycles\n",
+               "clock",
+               (unsigned long)millis,
+               (unsigned long)micros,
+               (unsigned long)counted,
+               (unsigned long)cycles);
+    }
+
+    return passed;
+}
+
+int main(void) {
+    bool passed = true;
+
+    sim_reset();
+
+    usart_init(BSP_USART0,
+               (usart_config){
+                   .baud_rate            = USART_BAUD_115200,
+                   .rx_buffer            = test_rx_buffer,
+                   .rx_buffer_size       = sizeof(test_rx_buffer),
+                   .tx_buffer            = test_tx_buffer,
+                   .tx_buffer_size       = sizeof(test_tx_buffer),
+                   .rx_delimiter_enabled = true,
+                   .rx_delimiter         = '\n',
+               });
+    io_configure(BSP_PD2, (io_config){.direction = IO_DIRECTION_INPUT});
+
+    passed &= test_usart_baud();
+    passed &= test_queue_reserve_wrap();
+    passed &= test_spsc_stress("spsc stress (generic)", STRESS_GENERIC);
+    passed &= test_spsc_stress("spsc stress (reserve)", STRESS_GENERIC_RESERVE);
+    passed &= test_spsc_stress("spsc stress (typed)", STRESS_TYPED);
+    passed &= test_usart_printf_long();
+    passed &= test_usart_printf_P_limit();
+
+    passed &= test_io_event("INT0 edge", BSP_PD2, IO_EDGE_BOTH);
+    passed &= test_io_event("INT0 rising", BSP_PD2, IO_EDGE_RISING);
+
+    // Watch a second pin of port B, so that the handler has to pick out the one that changed
+    io_event_register(BSP_PB1, IO_EDGE_BOTH, test_io_event_callback);
+    passed &= test_io_event("PCINT0 edge", BSP_PB0, IO_EDGE_BOTH);
+    passed &= test_io_event("PCINT0 falling", BSP_PB0, IO_EDGE_FALLING);
+    io_event_unregister(BSP_PB1);
+    passed &= test_io_event_pending();
+
+    // 20 inputs: all of port B, PC0 to PC5 and PD2 to PD7
+    debounce_init(1);
+    debounce_add_mask(IO_PORT_B, 0xFF);
+    debounce_add_mask(IO_PORT_C, 0x3F);
+    debounce_add_mask(IO_PORT_D, 0xFC);
+    passed &= test_debounce_check();
+
+    passed &= test_clock_check();
+    passed &= test_usart_frame_events();
+    passed &= test_usart_readline_overflow();
+    passed &= test_usart_stats();
+    passed &= test_usart_blocking();
+    passed &= test_usart_echo();
+    passed &= test_usart_framing("usart COBS framing", USART_FRAMING_COBS);
+    passed &= test_usart_framing("usart SLIP framing", USART_FRAMING_SLIP);
+    passed &= test_usart_flow_control();
+    passed &= test_sched();
+    passed &= test_spi();
+    passed &= test_i2c();
+
+    printf("%s\n", passed ? "all tests passed" : "some tests FAILED");
+    return passed ? 0 : 1;
+}
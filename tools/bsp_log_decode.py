@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""Decode binary bsp_log() records (see include/bsp/util/log.h) into text.
+
+The format strings are read out of the firmware ELF: each record carries the flash address of its
+format string, which is looked up in the ELF's allocated sections. Records are read from a file, a
+serial device (configure its baud rate first, e.g. with stty) or stdin.
+
+Usage: bsp_log_decode.py firmware.elf [input]
+"""
+
+import re
+import struct
+import sys
+
+LOG_RECORD_SYNC = 0xA5
+
+# Sizes of the C types that arguments are encoded as, on the ATmega328P (avr-gcc ABI)
+SIZEOF_INT = 2
+SIZEOF_LONG = 4
+SIZEOF_LONG_LONG = 8
+SIZEOF_DOUBLE = 4
+SIZEOF_POINTER = 2
+
+# Addresses at or above this are in the AVR's data address space, not flash
+AVR_DATA_ADDRESS = 0x800000
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t)?([diuxXobcfFeEgGps%])")
+
+
+class Elf:
+    """The allocated flash sections of a 32-bit little-endian ELF file."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path}: not a 32-bit little-endian ELF file")
+
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+
+        self.sections = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize
+            )
+            # Keep allocated (SHF_ALLOC) sections with contents (not SHT_NOBITS) in flash
+            if flags & 0x2 and sh_type != 8 and addr < AVR_DATA_ADDRESS:
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", "replace")
+
+        return None
+
+
+def format_record(format_string, args):
+    """Apply a C format string to raw argument bytes, returning the text."""
+    values = []
+    pos = 0
+
+    def take(size, kind):
+        nonlocal pos
+        if pos + size > len(args):
+            raise IndexError
+        chunk = args[pos : pos + size]
+        pos += size
+
+        if kind == "s":
+            return int.from_bytes(chunk, "little", signed=True)
+        if kind == "u":
+            return int.from_bytes(chunk, "little", signed=False)
+        return struct.unpack("<f" if size == 4 else "<d", chunk)[0]
+
+    def int_size(length):
+        if length in (None, "h", "hh", "z", "t"):
+            return SIZEOF_INT
+        return SIZEOF_LONG if length == "l" else SIZEOF_LONG_LONG
+
+    def convert(match):
+        nonlocal pos
+        flags, width, precision, length, conversion = match.groups()
+        if conversion == "%":
+            return "%%"
+
+        try:
+            if width == "*":
+                values.append(take(SIZEOF_INT, "s"))
+            if precision == "*":
+                values.append(take(SIZEOF_INT, "s"))
+
+            if conversion in "di":
+                values.append(take(int_size(length), "s"))
+            elif conversion in "uxXob":
+                values.append(take(int_size(length), "u"))
+                if conversion == "b":
+                    values[-1] = format(values[-1], "b")
+                    conversion = "s"
+            elif conversion == "c":
+                values.append(take(1, "u"))
+            elif conversion in "fFeEgG":
+                values.append(take(SIZEOF_DOUBLE, "f"))
+            elif conversion == "p":
+                values.append(take(SIZEOF_POINTER, "u"))
+                return "0x%04x"
+            elif conversion == "s":
+                end = args.index(b"\0", pos)
+                values.append(args[pos:end].decode("utf-8", "replace"))
+                pos = end + 1
+        except (IndexError, ValueError):
+            values.append("<truncated>")
+            return "%s"
+
+        spec = "%" + flags + (width or "")
+        if precision is not None:
+            spec += "." + precision
+        return spec + ("d" if conversion in "iu" else conversion)
+
+    python_format = CONVERSION.sub(convert, format_string)
+    return python_format % tuple(values)
+
+
+def decode(elf, stream, out):
+    buffer = bytearray()
+
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        buffer += chunk
+
+        # Resynchronize on the sync byte, then wait for the whole record
+        while buffer and buffer[0] != LOG_RECORD_SYNC:
+            del buffer[0]
+        if len(buffer) < 2 or len(buffer) < 2 + buffer[1]:
+            continue
+
+        record = bytes(buffer[2 : 2 + buffer[1]])
+        del buffer[: 2 + len(record)]
+
+        if len(record) < 6:
+            continue
+
+        address, timestamp = struct.unpack_from("<HI", record)
+        format_string = elf.string_at(address)
+
+        if format_string is None:
+            out.write(f"[{timestamp:10}] <unknown format at 0x{address:04x}>\n")
+        else:
+            text = format_record(format_string, record[6:])
+            out.write(f"[{timestamp:10}] {text.rstrip(chr(10))}\n")
+        out.flush()
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 2
+
+    elf = Elf(argv[1])
+
+    if len(argv) == 3:
+        with open(argv[2], "rb", buffering=0) as stream:
+            decode(elf, stream, sys.stdout)
+    else:
+        decode(elf, sys.stdin.buffer, sys.stdout)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))